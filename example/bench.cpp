@@ -0,0 +1,149 @@
+#include "inicpp.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+/**
+ * Throughput gate: parse MB/s and set() latency against a checked-in baseline.
+ * make bench                                  fails if worse than the baseline by more than its threshold
+ * ./iniBench bench_baseline.txt --update      writes the measured numbers as new baseline
+ *
+ * baseline file:
+ *   parse_mb_s <MB/s>
+ *   set_ms <ms per set() on the file>
+ *   threshold <allowed regression, 0.4 = 40%>
+ */
+
+#define BENCH_FILE "bench.ini"
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	typedef struct Baseline
+	{
+		double parseMBs = 0;
+		double setMs = 0;
+		double threshold = 0.4;
+	} Baseline;
+
+	bool readBaseline(const std::string &fileName, Baseline &baseline)
+	{
+		std::ifstream input(fileName);
+		std::string name;
+		double value;
+		while (input >> name >> value)
+		{
+			if (name == "parse_mb_s")
+			{
+				baseline.parseMBs = value;
+			}
+			else if (name == "set_ms")
+			{
+				baseline.setMs = value;
+			}
+			else if (name == "threshold")
+			{
+				baseline.threshold = value;
+			}
+		}
+		return baseline.parseMBs > 0 && baseline.setMs > 0;
+	}
+
+	// about 8MB: 20000 sections, 10 keys each, some comments
+	std::string generate()
+	{
+		std::string text = ";bench\n";
+		for (int section = 0; section < 20000; ++section)
+		{
+			text += "[section" + std::to_string(section) + "]\n";
+			if (section % 4 == 0)
+			{
+				text += ";comment of section " + std::to_string(section) + "\n";
+			}
+			for (int key = 0; key < 10; ++key)
+			{
+				text += "key" + std::to_string(key) + "=value of key " + std::to_string(key) + " in section " + std::to_string(section) + "\n";
+			}
+		}
+		return text;
+	}
+
+	double elapsedMs(Clock::time_point begin)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " <baseline file> [--update]" << std::endl;
+		return 2;
+	}
+	const std::string baselineFile = argv[1];
+	const bool isUpdate = argc > 2 && std::strcmp(argv[2], "--update") == 0;
+
+	const std::string text = generate();
+
+	// parse in memory, best of 5
+	double parseMs = 1e100;
+	for (int run = 0; run < 5; ++run)
+	{
+		inicpp::IniManager manager;
+		Clock::time_point begin = Clock::now();
+		manager.parse(text);
+		parseMs = std::min(parseMs, elapsedMs(begin));
+		if (manager.get("section19999", "key9", "") != "value of key 9 in section 19999")
+		{
+			std::cerr << "parse result is wrong" << std::endl;
+			return 1;
+		}
+	}
+	const double parseMBs = text.size() / 1048576.0 / (parseMs / 1000.0);
+
+	// set() on the file, a key in the middle
+	std::ofstream(BENCH_FILE, std::ofstream::binary | std::ofstream::trunc) << text;
+	inicpp::IniManager manager(BENCH_FILE);
+	const int setRuns = 20;
+	Clock::time_point begin = Clock::now();
+	for (int run = 0; run < setRuns; ++run)
+	{
+		manager.set("section10000", "key5", run);
+	}
+	const double setMs = elapsedMs(begin) / setRuns;
+	std::remove(BENCH_FILE);
+
+	std::cout << "parse: " << parseMBs << " MB/s, set: " << setMs << " ms" << std::endl;
+
+	Baseline baseline;
+	if (isUpdate)
+	{
+		readBaseline(baselineFile, baseline);
+		std::ofstream(baselineFile, std::ofstream::trunc) << "parse_mb_s " << parseMBs << "\nset_ms " << setMs << "\nthreshold " << baseline.threshold << "\n";
+		std::cout << "baseline " << baselineFile << " updated" << std::endl;
+		return 0;
+	}
+
+	if (!readBaseline(baselineFile, baseline))
+	{
+		std::cerr << "no baseline in " << baselineFile << ", create it with --update" << std::endl;
+		return 2;
+	}
+
+	bool isPassed = true;
+	if (parseMBs < baseline.parseMBs * (1 - baseline.threshold))
+	{
+		std::cerr << "parse regressed: " << parseMBs << " MB/s, baseline " << baseline.parseMBs << " MB/s" << std::endl;
+		isPassed = false;
+	}
+	if (setMs > baseline.setMs * (1 + baseline.threshold))
+	{
+		std::cerr << "set regressed: " << setMs << " ms, baseline " << baseline.setMs << " ms" << std::endl;
+		isPassed = false;
+	}
+	return isPassed ? 0 : 1;
+}
@@ -0,0 +1,315 @@
+#include "inicpp.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+/**
+ * Structured fuzzing of parse and set.
+ * libFuzzer (clang):  make fuzz && ./iniFuzz corpus/
+ * any compiler:       make fuzz-smoke    (own random driver, see INICPP_FUZZ_MAIN)
+ *
+ * Input: byte 0 are flags, the operations for set() are taken from the end, the rest is ini text.
+ * Invariants:
+ *   1. any text parses, with and without interpolation
+ *   2. serialize() is a fixed point: parse(serialize(x)) serializes to the same text
+ *   3. set() then a read returns the value written
+ *   4. the data after set() equals a full parse of the written text
+ *   5. the same writes in a batch end with the same values as one by one, and equal a full parse
+ */
+
+// abort on a broken invariant: libFuzzer keeps the input as crash file
+#define FUZZ_CHECK(x)                                                                 \
+	do                                                                                \
+	{                                                                                 \
+		if (!(x))                                                                     \
+		{                                                                             \
+			std::fprintf(stderr, "invariant failed: %s, line %d\n", #x, __LINE__);    \
+			std::abort();                                                             \
+		}                                                                             \
+	} while (0)
+
+namespace
+{
+	// bytes taken from the end of the fuzz input
+	typedef struct FuzzInput
+	{
+		const uint8_t *data;
+		size_t size;
+
+		uint8_t byte()
+		{
+			if (size == 0)
+			{
+				return 0;
+			}
+			return data[--size];
+		}
+
+		// section/key name, may be empty for section
+		std::string name(bool isEmptyAllowed)
+		{
+			static const char alphabet[] = "abcdefgh_0123";
+			size_t length = byte() % 6 + (isEmptyAllowed ? 0 : 1);
+			std::string result;
+			for (size_t i = 0; i < length; ++i)
+			{
+				result += alphabet[byte() % (sizeof(alphabet) - 1)];
+			}
+			return result;
+		}
+
+		// printable value without edge spaces and line breaks
+		std::string value()
+		{
+			static const char alphabet[] = "abcXYZ019 =;#[]:\"\\.-";
+			size_t length = byte() % 10 + 1;
+			std::string result;
+			for (size_t i = 0; i < length; ++i)
+			{
+				result += alphabet[byte() % (sizeof(alphabet) - 1)];
+			}
+			inicpp::IniParser::trimEdges(result);
+			return result.empty() ? "v" : result;
+		}
+	} FuzzInput;
+
+	typedef struct Operation
+	{
+		int kind; // 0: value, 1: value with comment, 2: array, 3: remove array, 4: assignment
+		std::string section, key, value;
+		std::vector<std::string> values;
+	} Operation;
+
+	std::string serialize(const inicpp::ini &data)
+	{
+		std::ostringstream output;
+		data.serialize(output);
+		return output.str();
+	}
+
+	// key-values with lines, and the line index
+	std::string dump(inicpp::ini data)
+	{
+		std::ostringstream output;
+		data.serialize(output);
+		for (int line = 1; line <= static_cast<int>(data.lineOffsets().size()) + 1; ++line)
+		{
+			output << data.getLineOffset(line) << (data.isCommentLine(line) ? "c," : ",");
+		}
+		output << "|" << data.getDataSize() << "|";
+		for (const auto &sectionName : data.getSectionsList())
+		{
+			output << "[" << sectionName << ":" << data.getEndSection(sectionName) << "]";
+			for (const auto &keyValue : data.getSectionMap(sectionName))
+			{
+				output << keyValue.first << "@" << data.getLine(sectionName, keyValue.first) << ";";
+			}
+		}
+		return output.str();
+	}
+
+	// values of sections with keys, arrays with all values
+	std::string values(inicpp::ini data)
+	{
+		std::ostringstream output;
+		for (const auto &sectionName : data.getSectionsList())
+		{
+			for (const auto &keyValue : data.getSectionMap(sectionName))
+			{
+				output << "[" << sectionName << "]" << keyValue.first;
+				for (const auto &value : data.getValues(sectionName, keyValue.first))
+				{
+					output << "=" << value;
+				}
+				output << "\n";
+			}
+		}
+		return output.str();
+	}
+
+	bool apply(inicpp::IniManager &manager, const Operation &operation)
+	{
+		switch (operation.kind)
+		{
+		case 2:
+			return manager.set(operation.section, operation.key, operation.values);
+		case 3:
+			return manager.set(operation.section, operation.key, std::vector<std::string>());
+		case 4:
+			manager[operation.section][operation.key] = operation.value;
+			return true;
+		default:
+			return manager.set(operation.section, operation.key, operation.value, operation.kind == 1 ? "comment" : "");
+		}
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+
+	FuzzInput input{data + 1, size - 1};
+	const uint8_t flags = data[0];
+
+	std::vector<Operation> operations((flags >> 4) % 6);
+	std::vector<uint8_t> targets(operations.size());
+	for (std::size_t i = 0; i < operations.size(); ++i)
+	{
+		Operation &operation = operations[i];
+		operation.kind = input.byte() % 5;
+		operation.section = input.name(true);
+		operation.key = input.name(false);
+		operation.value = input.value();
+		for (int j = input.byte() % 3; j >= 0; --j)
+		{
+			operation.values.push_back(input.value());
+		}
+		targets[i] = input.byte();
+	}
+
+	const char *text = reinterpret_cast<const char *>(input.data);
+	const size_t textSize = input.size;
+
+	// 1. parse anything
+	inicpp::ini interpolated;
+	inicpp::IniParser::load(interpolated, text, textSize, true);
+
+	inicpp::ini parsed;
+	inicpp::IniParser::load(parsed, text, textSize, false);
+
+	// 2. serialize() is a fixed point
+	const std::string first = serialize(parsed);
+	inicpp::ini again;
+	inicpp::IniParser::load(again, first.data(), first.length(), false);
+	FUZZ_CHECK(serialize(again) == first);
+
+	// aim writes at keys of the text or of the write before, some with the value of the text back
+	std::vector<std::pair<std::string, std::string>> keys;
+	for (const auto &sectionName : parsed.getSectionsList())
+	{
+		for (const auto &keyValue : parsed.getSectionMap(sectionName))
+		{
+			const std::string &key = keyValue.first;
+			const char first = key.empty() ? ';' : key[0];
+			const bool isArrayName = key.length() > 2 && key.compare(key.length() - 2, 2, "[]") == 0; // written as array
+			if (first != ';' && first != '#' && first != '[' && !isArrayName) // others only read from indented lines
+			{
+				keys.push_back(std::make_pair(sectionName, keyValue.first));
+			}
+		}
+	}
+	for (std::size_t i = 0; i < operations.size(); ++i)
+	{
+		Operation &operation = operations[i];
+		if (targets[i] % 4 == 1 && !keys.empty())
+		{
+			operation.section = keys[(targets[i] >> 2) % keys.size()].first;
+			operation.key = keys[(targets[i] >> 2) % keys.size()].second;
+		}
+		else if (targets[i] % 4 == 2 && i > 0)
+		{
+			operation.section = operations[i - 1].section;
+			operation.key = operations[i - 1].key;
+		}
+
+		const inicpp::ValueNode *node = parsed.getNode(operation.section, operation.key);
+		if ((targets[i] & 0x80) && node && !node->isArray && !node->Value.empty())
+		{
+			operation.value = node->Value;
+		}
+	}
+
+	// 3. and 4. set() in memory
+	inicpp::IniManager manager;
+	manager.parse(text, textSize);
+	for (const auto &operation : operations)
+	{
+		FUZZ_CHECK(apply(manager, operation));
+		if (operation.kind == 2 || operation.kind == 3)
+		{
+			std::vector<std::string> values = operation.kind == 2 ? operation.values : std::vector<std::string>();
+			FUZZ_CHECK(manager.get(operation.section, operation.key, std::vector<std::string>()) == values);
+		}
+		else
+		{
+			FUZZ_CHECK(manager.get(operation.section, operation.key, "") == operation.value);
+		}
+
+		const std::string updated = dump(manager.snapshot());
+		manager.parse(); // full parse of the text in memory
+		FUZZ_CHECK(dump(manager.snapshot()) == updated);
+	}
+
+	// 5. batch
+	inicpp::IniManager batched;
+	batched.parse(text, textSize);
+	{
+		auto batch = batched.batch();
+		for (const auto &operation : operations)
+		{
+			FUZZ_CHECK(apply(batched, operation));
+		}
+		FUZZ_CHECK(batch.commit());
+	}
+	FUZZ_CHECK(values(batched.snapshot()) == values(manager.snapshot()));
+
+	const std::string committed = dump(batched.snapshot());
+	batched.parse();
+	FUZZ_CHECK(dump(batched.snapshot()) == committed);
+
+	return 0;
+}
+
+#ifdef INICPP_FUZZ_MAIN
+/**
+ * Without libFuzzer: ./iniFuzz [runs] runs random inputs built from ini fragments,
+ * ./iniFuzz file... runs saved inputs, e.g. a crash file of libFuzzer.
+ */
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !std::isdigit(static_cast<unsigned char>(argv[1][0])))
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::ifstream file(argv[i], std::ifstream::binary);
+			std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+		}
+		return 0;
+	}
+
+	static const char *fragments[] = {"[", "]", "=", "\n", "\r\n", ";", "#", " ", "\t", "key", "a", "sec", "[]", "${", "}", "${ENV:HOME}", ":", "\"", "\\"};
+	const int runs = argc > 1 ? std::atoi(argv[1]) : 10000;
+	std::mt19937 random(20240601);
+
+	for (int run = 0; run < runs; ++run)
+	{
+		std::string data(1, static_cast<char>(random()));
+		for (int i = random() % 64; i > 0; --i)
+		{
+			if (random() % 4 == 0)
+			{
+				data += static_cast<char>(random());
+			}
+			else
+			{
+				data += fragments[random() % (sizeof(fragments) / sizeof(fragments[0]))];
+			}
+		}
+		for (int i = 0; i < 32; ++i) // operations
+		{
+			data += static_cast<char>(random());
+		}
+		LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+	}
+
+	std::cout << "fuzz: " << runs << " runs passed" << std::endl;
+	return 0;
+}
+#endif
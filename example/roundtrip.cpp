@@ -0,0 +1,146 @@
+#include "inicpp.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+/**
+ * Round trip: every set() must be read back, by the same manager and by a fresh parse of the file.
+ * make roundtrip, exit code 1 on the first mismatch.
+ */
+
+#define ROUNDTRIP_FILE "roundtrip.ini"
+
+namespace
+{
+	typedef struct Expected
+	{
+		std::string section, key, value;
+		std::vector<std::string> values;
+		bool isArray;
+	} Expected;
+
+	std::string randomName(std::mt19937 &random, bool isEmptyAllowed)
+	{
+		static const char alphabet[] = "abcxyz_019";
+		std::string name;
+		for (int i = random() % 5 + (isEmptyAllowed ? 0 : 1); i > 0; --i)
+		{
+			name += alphabet[random() % (sizeof(alphabet) - 1)];
+		}
+		return name;
+	}
+
+	std::string randomValue(std::mt19937 &random)
+	{
+		static const char alphabet[] = "abcXYZ019 =;#[]:\"\\.-${}";
+		std::string value;
+		for (int i = random() % 12 + 1; i > 0; --i)
+		{
+			value += alphabet[random() % (sizeof(alphabet) - 1)];
+		}
+		inicpp::IniParser::trimEdges(value);
+		return value.empty() ? "v" : value;
+	}
+
+	bool check(inicpp::IniManager &manager, const Expected &expected, const char *where)
+	{
+		if (expected.isArray)
+		{
+			if (manager.get(expected.section, expected.key, std::vector<std::string>()) == expected.values)
+			{
+				return true;
+			}
+		}
+		else if (manager.get(expected.section, expected.key, "") == expected.value)
+		{
+			return true;
+		}
+
+		std::cerr << where << ": [" << expected.section << "] " << expected.key << " does not read back " << (expected.isArray ? "the array" : expected.value) << std::endl;
+		return false;
+	}
+}
+
+int main()
+{
+	std::remove(ROUNDTRIP_FILE);
+	std::ofstream(ROUNDTRIP_FILE) << ";round trip\n[server]\nip=127.0.0.1\nport=8080\n";
+
+	inicpp::IniManager writer(ROUNDTRIP_FILE);
+	std::mt19937 random(20240601);
+	std::map<std::pair<std::string, std::string>, Expected> written;
+
+	for (int step = 0; step < 1000; ++step)
+	{
+		Expected expected{randomName(random, true), randomName(random, false), "", {}, false};
+		switch (random() % 5)
+		{
+		case 0: // int
+		{
+			const int value = static_cast<int>(random() % 2000001) - 1000000;
+			writer.set(expected.section, expected.key, value);
+			expected.value = std::to_string(value);
+			break;
+		}
+		case 1: // double, written with std::to_string
+		{
+			const double value = static_cast<double>(random()) / 1000.0;
+			writer.set(expected.section, expected.key, value);
+			expected.value = std::to_string(value);
+			break;
+		}
+		case 2: // array
+		{
+			for (int i = random() % 4 + 1; i > 0; --i)
+			{
+				expected.values.push_back(randomValue(random));
+			}
+			writer.set(expected.section, expected.key, expected.values);
+			expected.isArray = true;
+			break;
+		}
+		default: // string, sometimes with comment
+		{
+			expected.value = randomValue(random);
+			writer.set(expected.section, expected.key, expected.value, random() % 2 ? "comment" : "");
+			break;
+		}
+		}
+
+		if (!check(writer, expected, "same manager"))
+		{
+			return 1;
+		}
+		written[std::make_pair(expected.section, expected.key)] = expected;
+
+		if (step % 50 == 0)
+		{
+			inicpp::IniManager reader(ROUNDTRIP_FILE);
+			for (const auto &data : written)
+			{
+				if (!check(reader, data.second, "fresh parse"))
+				{
+					return 1;
+				}
+			}
+		}
+	}
+
+	inicpp::IniManager reader(ROUNDTRIP_FILE);
+	for (const auto &data : written)
+	{
+		if (!check(reader, data.second, "fresh parse"))
+		{
+			return 1;
+		}
+	}
+	if (reader.get("server", "ip", "") != "127.0.0.1" && !written.count(std::make_pair(std::string("server"), std::string("ip"))))
+	{
+		std::cerr << "untouched key changed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "roundtrip: " << written.size() << " keys read back" << std::endl;
+	return 0;
+}
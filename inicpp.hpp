@@ -25,21 +25,66 @@
 #ifndef __JN_INICPP_H__
 #define __JN_INICPP_H__
 
+#include <cerrno>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <stdexcept>
 
 #include <fstream>
 #include <sstream>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <string>
+#if __cplusplus >= 201703L
+#include <optional>
+#include <string_view>
+#endif
 #include <list>
 #include <map>
+#include <memory>
+#include <regex>
+#include <set>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define INICPP_HAS_COROUTINE
+#endif
+#endif
+
+#if defined(_ENBABLE_INICPP_STD_WSTRING_) && defined(__SSE2__) // ascii check for UTF-8 => std::wstring
+#include <emmintrin.h>
+#endif
+
+#ifdef INICPP_ENABLE_ZLIB // gzip config, link with -lz
+#include <zlib.h>
+#endif
+
+#ifdef INICPP_ENABLE_ZSTD // zstd config, link with -lzstd
+#include <zstd.h>
+#endif
 
-#ifdef _ENBABLE_INICPP_STD_WSTRING_ // Not all of C++ 11 support <codecvt>
-// for std::string <==> std::wstring convert
-#include <codecvt>
-#include <locale>
+#if defined(__unix__) || defined(__APPLE__) // file rewrite with fd and kernel-side copy
+#define INICPP_POSIX_IO
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define INICPP_HAS_COPY_FILE_RANGE
+#endif
+#endif
 #endif
 
 #ifdef INICPP_DEBUG
@@ -51,18 +96,31 @@
 class TimeFormatter
 {
 public:
+	// thread-safe: localtime_r/localtime_s, no shared std::tm
 	static std::string format(const std::string &format = "%Y-%m-%d %H:%M:%S")
 	{
 		std::time_t t = std::time(nullptr);
-		std::tm tm = *std::localtime(&t);
+		std::tm tm;
+#ifdef _WIN32
+		localtime_s(&tm, &t);
+#else
+		localtime_r(&t, &tm);
+#endif
 		std::array<char, 100> buffer;
 		std::strftime(buffer.data(), buffer.size(), format.c_str(), &tm);
 		return buffer.data();
 	}
 };
 
-#define CODE_INFO std::string(" \t``````|") + std::string(__FILE__) + ":" + std::to_string(__LINE__) + "  fun:" + std::string(__FUNCTION__)
-#define INI_DEBUG(x) std::cout << "INICPP " << TimeFormatter::format() << " : " << x << CODE_INFO << std::endl
+// one line written at once, without flush
+#define CODE_INFO " \t``````|" << __FILE__ << ":" << __LINE__ << "  fun:" << __FUNCTION__
+#define INI_DEBUG(x)                                                                      \
+	do                                                                                    \
+	{                                                                                     \
+		std::ostringstream _iniDebugLine;                                                 \
+		_iniDebugLine << "INICPP " << TimeFormatter::format() << " : " << x << CODE_INFO << '\n'; \
+		std::cout << _iniDebugLine.str();                                                 \
+	} while (0)
 
 #else // #ifdef INICPP_DEBUG
 #define INI_DEBUG(x)
@@ -71,12 +129,383 @@ public:
 namespace inicpp
 {
 
+	/**
+	 * Trace of parse/set/reload as begin and end events of spans, for profiling in production.
+	 * No sink is set by default: a span then costs one atomic load.
+	 *   inicpp::TraceRingBuffer trace(4096);
+	 *   inicpp::setTraceSink(&trace);
+	 *   ...
+	 *   std::ofstream output("trace.json");
+	 *   trace.exportChromeTrace(output); // open in chrome://tracing or Perfetto
+	 */
+	typedef struct TraceEvent
+	{
+		const char *name;		 // static string: "parse", "set", ...
+		char phase;				 // 'B': begin, 'E': end
+		std::uint32_t thread;	 // small id of the thread
+		std::uint64_t timestamp; // steady clock, nanoseconds
+	} TraceEvent;
+
+	// receives events from any thread at the same time
+	class TraceSink
+	{
+	public:
+		virtual ~TraceSink() {}
+		virtual void event(const TraceEvent &event) = 0;
+	};
+
+	inline std::atomic<TraceSink *> &traceSinkSlot()
+	{
+		static std::atomic<TraceSink *> sink(nullptr);
+		return sink;
+	}
+
+	// nullptr to stop tracing; the sink must outlive the spans running on it
+	inline void setTraceSink(TraceSink *sink)
+	{
+		traceSinkSlot().store(sink, std::memory_order_release);
+	}
+
+	inline TraceSink *traceSink()
+	{
+		return traceSinkSlot().load(std::memory_order_acquire);
+	}
+
+	inline std::uint64_t traceNow()
+	{
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	inline std::uint32_t traceThread()
+	{
+		static std::atomic<std::uint32_t> next(0);
+		static thread_local std::uint32_t thread = ++next;
+		return thread;
+	}
+
+	// begin event now, end event when out of scope
+	class TraceSpan
+	{
+	public:
+		explicit TraceSpan(const char *name) : _name(name), _sink(traceSink())
+		{
+			if (_sink)
+			{
+				_sink->event(TraceEvent{_name, 'B', traceThread(), traceNow()});
+			}
+		}
+
+		~TraceSpan()
+		{
+			if (_sink)
+			{
+				_sink->event(TraceEvent{_name, 'E', traceThread(), traceNow()});
+			}
+		}
+
+		TraceSpan(const TraceSpan &) = delete;
+		TraceSpan &operator=(const TraceSpan &) = delete;
+
+	private:
+		const char *_name;
+		TraceSink *_sink;
+	};
+
+	/**
+	 * Lock-free sink keeping the last capacity events (rounded up to a power of 2).
+	 * Writers never wait: each claims a slot with one fetch_add, a seqlock per slot
+	 * lets events() skip the slots being written.
+	 */
+	class TraceRingBuffer : public TraceSink
+	{
+	public:
+		explicit TraceRingBuffer(std::size_t capacity = 65536)
+		{
+			std::size_t size = 1;
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+			_slots = std::unique_ptr<Slot[]>(new Slot[size]);
+			_mask = size - 1;
+		}
+
+		void event(const TraceEvent &event) override
+		{
+			std::uint64_t index = _head.fetch_add(1, std::memory_order_relaxed);
+			Slot &slot = _slots[index & _mask];
+
+			slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			slot.event = event;
+			slot.sequence.store(index * 2 + 2, std::memory_order_release);
+		}
+
+		// events still in buffer, oldest first
+		std::vector<TraceEvent> events() const
+		{
+			std::vector<TraceEvent> result;
+			std::uint64_t head = _head.load(std::memory_order_acquire);
+			std::uint64_t first = head > _mask + 1 ? head - (_mask + 1) : 0;
+			result.reserve(static_cast<std::size_t>(head - first));
+
+			for (std::uint64_t index = first; index < head; ++index)
+			{
+				const Slot &slot = _slots[index & _mask];
+				if (slot.sequence.load(std::memory_order_acquire) != index * 2 + 2)
+				{
+					continue; // being written, or overwritten by a newer event
+				}
+				TraceEvent event = slot.event;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot.sequence.load(std::memory_order_relaxed) == index * 2 + 2)
+				{
+					result.push_back(event);
+				}
+			}
+			return result;
+		}
+
+		// Chrome trace event format, timestamps in microseconds
+		void exportChromeTrace(std::ostream &output) const
+		{
+			output << "{\"traceEvents\":[";
+			bool isFirst = true;
+			for (const auto &event : events())
+			{
+				output << (isFirst ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+					   << "\",\"ts\":" << event.timestamp / 1000 << "." << static_cast<char>('0' + event.timestamp % 1000 / 100)
+					   << static_cast<char>('0' + event.timestamp % 100 / 10) << static_cast<char>('0' + event.timestamp % 10)
+					   << ",\"pid\":1,\"tid\":" << event.thread << "}";
+				isFirst = false;
+			}
+			output << "\n]}\n";
+		}
+
+	private:
+		typedef struct Slot
+		{
+			std::atomic<std::uint64_t> sequence{0}; // odd while written, 2 * index + 2 when done
+			TraceEvent event{};
+		} Slot;
+
+		std::unique_ptr<Slot[]> _slots;
+		std::uint64_t _mask = 0;
+		std::atomic<std::uint64_t> _head{0};
+	};
+
 	typedef struct ValueNode
 	{
 		std::string Value = "";
-		int lineNumber = -1; // text line start with 1
+		int lineNumber = -1;		// text line start with 1
+		std::size_t generation = 0; // ini generation of the last value change
+		std::string Raw = "";		// text in file when Value is interpolated from ${...}
+
+		bool isArray = false;			 // repeated key or key[]=value
+		std::vector<std::string> Values; // all values of array in file order, Value is the last one
+		std::vector<int> valueLines;	 // line of each value of array
+		std::vector<std::string> RawValues; // text in file of array values when any is interpolated
+
+#ifdef _ENBABLE_INICPP_STD_WSTRING_
+		std::wstring WValue; // cache of Value for toWString()
+		bool isWValueValid = false;
+#endif
+
+		bool isSameValue(const ValueNode &other) const
+		{
+			return Value == other.Value && isArray == other.isArray && (!isArray || Values == other.Values);
+		}
+
+		// call after Value changed
+		void resetCache()
+		{
+#ifdef _ENBABLE_INICPP_STD_WSTRING_
+			isWValueValid = false;
+			WValue.clear();
+#endif
+		}
 	} ValueNode;
 
+#ifdef _ENBABLE_INICPP_STD_WSTRING_
+	/**
+	 * UTF-8 <==> std::wstring: UTF-16 for 2 bytes wchar_t, UTF-32 for 4 bytes.
+	 * Throws std::range_error for invalid input, like std::wstring_convert.
+	 */
+	class WStringConverter
+	{
+	public:
+		static std::wstring fromBytes(const std::string &data)
+		{
+			std::wstring result;
+			result.reserve(data.length());
+
+			const unsigned char *begin = reinterpret_cast<const unsigned char *>(data.data());
+			const unsigned char *end = begin + data.length();
+			const unsigned char *iter = begin;
+
+			while (iter < end)
+			{
+				std::size_t ascii = asciiLength(iter, end);
+				std::size_t size = result.size();
+				result.resize(size + ascii);
+				wchar_t *out = &result[0] + size;
+				for (std::size_t i = 0; i < ascii; ++i) // widen ascii run
+				{
+					out[i] = static_cast<wchar_t>(iter[i]);
+				}
+				iter += ascii;
+
+				if (iter == end)
+				{
+					break;
+				}
+
+				std::uint32_t codePoint = 0;
+				std::size_t length = 0;
+				if (*iter >= 0xC2 && *iter <= 0xDF)
+				{
+					codePoint = *iter & 0x1F;
+					length = 2;
+				}
+				else if (*iter >= 0xE0 && *iter <= 0xEF)
+				{
+					codePoint = *iter & 0x0F;
+					length = 3;
+				}
+				else if (*iter >= 0xF0 && *iter <= 0xF4)
+				{
+					codePoint = *iter & 0x07;
+					length = 4;
+				}
+				else
+				{
+					throw std::range_error("inicpp: invalid UTF-8 lead byte");
+				}
+
+				if (static_cast<std::size_t>(end - iter) < length)
+				{
+					throw std::range_error("inicpp: truncated UTF-8 sequence");
+				}
+
+				for (std::size_t i = 1; i < length; ++i)
+				{
+					if ((iter[i] & 0xC0) != 0x80)
+					{
+						throw std::range_error("inicpp: invalid UTF-8 continuation byte");
+					}
+					codePoint = (codePoint << 6) | (iter[i] & 0x3F);
+				}
+
+				static const std::uint32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+				if (codePoint < minimum[length] || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+				{
+					throw std::range_error("inicpp: invalid UTF-8 code point");
+				}
+
+				if (sizeof(wchar_t) == 2 && codePoint >= 0x10000)
+				{
+					codePoint -= 0x10000;
+					result.push_back(static_cast<wchar_t>(0xD800 + (codePoint >> 10)));
+					result.push_back(static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF)));
+				}
+				else
+				{
+					result.push_back(static_cast<wchar_t>(codePoint));
+				}
+
+				iter += length;
+			}
+
+			return result;
+		}
+
+		static std::string toBytes(const std::wstring &data)
+		{
+			std::string result;
+			result.reserve(data.length());
+
+			for (std::size_t i = 0; i < data.length(); ++i)
+			{
+				std::uint32_t codePoint = static_cast<std::uint32_t>(data[i]);
+
+				if (codePoint < 0x80)
+				{
+					result.push_back(static_cast<char>(codePoint));
+					continue;
+				}
+
+				if (sizeof(wchar_t) == 2 && codePoint >= 0xD800 && codePoint <= 0xDBFF && i + 1 < data.length())
+				{
+					std::uint32_t low = static_cast<std::uint32_t>(data[i + 1]);
+					if (low >= 0xDC00 && low <= 0xDFFF)
+					{
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						++i;
+					}
+				}
+
+				if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+				{
+					throw std::range_error("inicpp: invalid wide character");
+				}
+
+				if (codePoint < 0x800)
+				{
+					result.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+				}
+				else if (codePoint < 0x10000)
+				{
+					result.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+					result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+				}
+				else
+				{
+					result.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+					result.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+					result.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+				}
+				result.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			}
+
+			return result;
+		}
+
+	private:
+		// length of the leading ascii bytes, 16 (SSE2) or 8 bytes per step
+		static std::size_t asciiLength(const unsigned char *begin, const unsigned char *end)
+		{
+			const unsigned char *iter = begin;
+#ifdef __SSE2__
+			while (end - iter >= 16)
+			{
+				int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(iter)));
+				if (mask != 0)
+				{
+					return (iter - begin) + __builtin_ctz(static_cast<unsigned int>(mask));
+				}
+				iter += 16;
+			}
+#else
+			while (end - iter >= 8)
+			{
+				std::uint64_t block;
+				std::memcpy(&block, iter, sizeof(block));
+				if (block & 0x8080808080808080ULL)
+				{
+					break;
+				}
+				iter += 8;
+			}
+#endif
+			while (iter < end && *iter < 0x80)
+			{
+				++iter;
+			}
+			return iter - begin;
+		}
+	};
+#endif
+
 	class parentHelper
 	{
 	public:
@@ -93,16 +522,33 @@ namespace inicpp
 			INI_DEBUG("called parentHelper virtual impl: need to impl set");
 			return true;
 		};
+		// writes are recorded, not applied: a proxy can not skip a value equal to the one it read
+		virtual bool isBatching()
+		{
+			return false;
+		};
 	};
 
 	class ValueProxy
 	{
 	public:
-		ValueProxy(std::string &value) : _value(value) {}
+		ValueProxy(std::string &value) : _value(&value) {}
 		~ValueProxy() {}
 
+		// owns a copy of the value: read-only proxy, nothing to write back to
+		ValueProxy(const std::string &value) : _ownedValue(value), _value(&_ownedValue) {}
+
 		template <typename T>
-		ValueProxy(const T &value) : _value(to_string(value)) {}
+		ValueProxy(const T &value) : _ownedValue(to_string(value)), _value(&_ownedValue) {}
+
+		ValueProxy(const ValueProxy &other)
+			: _ownedValue(other._ownedValue), _value(other._value == &other._ownedValue ? &_ownedValue : other._value),
+			  _values(other._values), _sectionName(other._sectionName), _keyName(other._keyName), _section(other._section)
+		{
+		}
+
+		// a proxy is not rebound, assign its value instead
+		ValueProxy &operator=(const ValueProxy &) = delete;
 
 		template <typename T>
 		static std::string to_string(const T &value)
@@ -112,16 +558,13 @@ namespace inicpp
 			return oss.str();
 		}
 
+		// get<std::vector<T>>() for array: key[]=value or repeated key
 		template <typename T>
 		T get() const
 		{
 			static_assert(!std::is_pointer<T>::value, "Pointer types are not supported for conversion.");
-			std::istringstream iss(_value);
 			T result;
-			if (!(iss >> result))
-			{
-				throw std::runtime_error("Type mismatch or invalid conversion. with(section-key-value): "  +_sectionName +"-"+ _keyName +"-"+ _value); // error notify
-			}
+			convert(static_cast<T *>(nullptr), result);
 			return result;
 		}
 
@@ -142,7 +585,7 @@ namespace inicpp
 		// false:'0' or 'false', true : others
 		operator bool() const
 		{
-			if (_value == "0" || _value == "false" || _value == "no")
+			if (*_value == "0" || *_value == "false" || *_value == "no")
 			{
 				return false;
 			}
@@ -151,12 +594,12 @@ namespace inicpp
 
 		operator std::string() const
 		{
-			return _value;
+			return *_value;
 		}
 
 		friend std::ostream &operator<<(std::ostream &os, const ValueProxy &proxy)
 		{
-			os << proxy._value;
+			os << *proxy._value;
 			return os;
 		}
 
@@ -166,31 +609,31 @@ namespace inicpp
 		{
 			std::string value = this->to_string(other);
 
-			if (_value != value)
+			if (*_value != value || _values || isBatching()) // an array becomes this one value
 			{
 				set(value);
 			}
 
-			_value = value;
+			*_value = value;
 			return *this;
 		}
 
 		ValueProxy &operator=(const std::string &other)
 		{
-			if (_value != other)
+			if (*_value != other || _values || isBatching())
 			{
 				INI_DEBUG("Value Proxy Wanna Set Value: " << other);
 				set(other);
 			}
 
-			_value = other;
+			*_value = other;
 			return *this;
 		}
 
 		// specify std::string
-		const std::string &String() noexcept
+		const std::string &String() const noexcept
 		{
-			return _value;
+			return *_value;
 		}
 
 		inline void setWriteCB(parentHelper *sectionObj, const std::string &sectionName, const std::string &keyName)
@@ -200,7 +643,53 @@ namespace inicpp
 			_keyName = keyName;
 		}
 
+		inline void setValues(const std::vector<std::string> *values)
+		{
+			_values = values;
+		}
+
 	private:
+		template <typename T>
+		void convert(T *, T &result) const
+		{
+			convert(*_value, result);
+		}
+
+		template <typename T>
+		void convert(std::vector<T> *, std::vector<T> &result) const
+		{
+			if (!_values)
+			{
+				result.resize(_value->empty() ? 0 : 1);
+				if (!result.empty())
+				{
+					convert(*_value, result[0]);
+				}
+				return;
+			}
+
+			result.resize(_values->size());
+			for (std::size_t i = 0; i < result.size(); ++i)
+			{
+				convert((*_values)[i], result[i]);
+			}
+		}
+
+		template <typename T>
+		void convert(const std::string &value, T &result) const
+		{
+			std::istringstream iss(value);
+			if (!(iss >> result))
+			{
+				throw std::runtime_error("Type mismatch or invalid conversion. with(section-key-value): "  +_sectionName +"-"+ _keyName +"-"+ value); // error notify
+			}
+		}
+
+		void convert(const std::string &value, std::string &result) const
+		{
+			result = value;
+		}
+
 		void set(const std::string &value)
 		{
 			if (value.empty() || _keyName.empty())
@@ -213,8 +702,16 @@ namespace inicpp
 			}
 		}
 
+		// in a batch the value read may be older than a recorded write
+		bool isBatching() const
+		{
+			return _section && _section->parent() && _section->parent()->parent() && _section->parent()->parent()->isBatching();
+		}
+
 	private:
-		std::string &_value;
+		std::string _ownedValue; // see ValueProxy(const std::string &)
+		std::string *_value;
+		const std::vector<std::string> *_values = nullptr; // array only
 
 		std::string _sectionName, _keyName;
 		parentHelper *_section = nullptr;
@@ -224,6 +721,21 @@ namespace inicpp
 namespace inicpp
 {
 
+	// changed section-keys between two snapshots of ini
+	typedef struct IniDiff
+	{
+		typedef std::pair<std::string /*Section*/, std::string /*Key*/> Entry;
+
+		std::list<Entry> added, removed, modified;
+
+		bool empty() const
+		{
+			return added.empty() && removed.empty() && modified.empty();
+		}
+	} IniDiff;
+
+	class ini;
+
 	class section : parentHelper
 	{
 	public:
@@ -235,18 +747,15 @@ namespace inicpp
 		{
 		}
 
-		const std::string &name()
+		const std::string &name() const
 		{
 			return _sectionName;
 		}
 
-		const std::string getValue(const std::string &Key)
+		const std::string getValue(const std::string &Key) const
 		{
-			if (!_sectionMap.count(Key))
-			{
-				return "";
-			}
-			return _sectionMap[Key].Value;
+			const ValueNode *node = getNode(Key);
+			return node ? node->Value : "";
 		}
 
 		void setName(const std::string &name, const int &lineNumber)
@@ -257,51 +766,190 @@ namespace inicpp
 
 		void setValue(const std::string &Key, const std::string &Value, const int line)
 		{
-			_sectionMap[Key].Value = Value;
-			_sectionMap[Key].lineNumber = line;
-		}
-
-		void append(section &sec)
-		{
-			_sectionMap.insert(sec._sectionMap.begin(), sec._sectionMap.end());
+			_isHashValid = false;
+
+			ValueNode &node = _sectionMap[Key];
+			node.Value = Value;
+			node.resetCache();
+			node.Raw.clear();
+			node.lineNumber = line;
+			node.isArray = false;
+			node.Values.clear();
+			node.RawValues.clear();
+			node.valueLines.clear();
+
+			if (line > _endLine)
+			{
+				_endLine = line;
+			}
 		}
 
-		bool isKeyExist(const std::string &Key)
+		// keep every value of a repeated key or key[]=value as array
+		void addValue(const std::string &Key, const std::string &Value, const int line, bool isArray = false)
 		{
-			return !_sectionMap.count(Key) ? false : true;
-		}
+			auto iter = _sectionMap.find(Key);
+			if (iter == _sectionMap.end() || iter->second.lineNumber < 0)
+			{
+				setValue(Key, Value, line);
+				if (!isArray)
+				{
+					return;
+				}
+				iter = _sectionMap.find(Key);
+			}
 
-		int getEndSection()
-		{
-			int line = -1;
+			ValueNode &node = iter->second;
+			if (!node.isArray)
+			{
+				node.isArray = true;
+				node.Values.assign(1, node.Value);
+				node.valueLines.assign(1, node.lineNumber);
+			}
 
-			if (_sectionMap.empty() && _sectionName != "")
+			if (node.valueLines.back() != line)
 			{
-				return _lineNumber;
+				node.Values.push_back(Value);
+				node.valueLines.push_back(line);
 			}
+			node.Value = Value;
+			node.resetCache();
+			node.lineNumber = line;
 
-			for (const auto &data : _sectionMap)
+			_isHashValid = false;
+			if (line > _endLine)
 			{
-				if (data.second.lineNumber > line)
+				_endLine = line;
+			}
+		}
+
+		void append(section &sec)
+		{
+			_isHashValid = false;
+
+			for (const auto &data : sec._sectionMap) // same key in sections with same name: array
+			{
+				if (!data.second.isArray)
+				{
+					addValue(data.first, data.second.Value, data.second.lineNumber);
+					continue;
+				}
+				for (std::size_t i = 0; i < data.second.Values.size(); ++i)
 				{
-					line = data.second.lineNumber;
+					addValue(data.first, data.second.Values[i], data.second.valueLines[i], true);
 				}
 			}
-			return line;
+
+			if (sec._endLine > _endLine)
+			{
+				_endLine = sec._endLine;
+			}
 		}
 
-		int getLine(const std::string &Key)
+		bool isKeyExist(const std::string &Key) const
+		{
+			return !_sectionMap.count(Key) ? false : true;
+		}
+
+		// content hash of all key-values, for quick compare of sections
+		std::size_t hash() const
 		{
-			if (!_sectionMap.count(Key))
+			if (_isHashValid)
 			{
-				return -1;
+				return _hash;
+			}
+
+			std::uint64_t hash = 14695981039346656037ULL;
+			std::hash<std::string> hasher;
+			auto mix = [&hash, &hasher](const std::string &data)
+			{
+				hash = (hash ^ static_cast<std::uint64_t>(hasher(data))) * 1099511628211ULL;
+			};
+
+			for (const auto &data : _sectionMap)
+			{
+				mix(data.first);
+				mix(data.second.Value);
+				if (data.second.isArray)
+				{
+					for (const auto &value : data.second.Values)
+					{
+						mix(value);
+					}
+				}
+			}
+
+			_hash = static_cast<std::size_t>(hash);
+			_isHashValid = true;
+			return _hash;
+		}
+
+		// ini generation of the last change in this section
+		inline std::size_t generation() const { return _generation; }
+
+		// keep generations of unchanged key-values, stamp others with current
+		void updateGeneration(const section *previous, std::size_t current)
+		{
+			if (previous && previous->_sectionMap.size() == _sectionMap.size() && previous->hash() == hash())
+			{
+				auto prev = previous->_sectionMap.begin();
+				bool isSameKeys = true;
+				for (auto &data : _sectionMap) // same key-values, unless the hash collides
+				{
+					if (prev->first != data.first || !prev->second.isSameValue(data.second))
+					{
+						isSameKeys = false;
+						break;
+					}
+					data.second.generation = (prev++)->second.generation;
+				}
+				if (isSameKeys)
+				{
+					_generation = previous->_generation;
+					return;
+				}
+			}
+
+			for (auto &data : _sectionMap)
+			{
+				const ValueNode *node = previous ? previous->getNode(data.first) : nullptr;
+				data.second.generation = (node && node->isSameValue(data.second)) ? node->generation : current;
+			}
+			_generation = current;
+		}
+
+		// nullptr if not found, never insert
+		const ValueNode *getNode(const std::string &Key) const
+		{
+			auto iter = _sectionMap.find(Key);
+			if (iter == _sectionMap.end())
+			{
+				return nullptr;
+			}
+			return &iter->second;
+		}
+
+		// last key line of this section, tracked by setValue()/append()
+		int getEndSection() const
+		{
+			if (_sectionMap.empty() && _sectionName != "")
+			{
+				return _lineNumber;
 			}
-			return _sectionMap[Key].lineNumber;
+			return _endLine;
+		}
+
+		int getLine(const std::string &Key) const
+		{
+			const ValueNode *node = getNode(Key);
+			return node ? node->lineNumber : -1;
 		}
 
 		void clear()
 		{
 			_lineNumber = -1;
+			_endLine = -1;
+			_generation = 0;
+			_isHashValid = false;
 			_sectionName.clear();
 			_sectionMap.clear();
 		}
@@ -311,9 +959,10 @@ namespace inicpp
 			return _sectionMap.empty();
 		}
 
-		int toInt(const std::string &Key) noexcept
+		int toInt(const std::string &Key) const noexcept
 		{
-			if (!_sectionMap.count(Key))
+			const ValueNode *node = getNode(Key);
+			if (!node)
 			{
 				return 0;
 			}
@@ -322,40 +971,61 @@ namespace inicpp
 
 			try
 			{
-				result = std::stoi(_sectionMap[Key].Value);
+				result = std::stoi(node->Value);
 			}
 			catch (const std::invalid_argument &e)
 			{
-				INI_DEBUG("Invalid argument: " << e.what() << ",input:\'" << _sectionMap[Key].Value << "\'");
+				INI_DEBUG("Invalid argument: " << e.what() << ",input:\'" << node->Value << "\'");
 			}
 			catch (const std::out_of_range &e)
 			{
-				INI_DEBUG("Out of range: " << e.what() << ",input:\'" << _sectionMap[Key].Value << "\'");
+				INI_DEBUG("Out of range: " << e.what() << ",input:\'" << node->Value << "\'");
 			}
 
 			return result;
 		}
 
-		std::string toString(const std::string &Key) noexcept
+		std::string toString(const std::string &Key) const noexcept
+		{
+			const ValueNode *node = getNode(Key);
+			return node ? node->Value : "";
+		}
+
+		// all values of array, or the only value of a key; IniManager::getValues() without copy
+		std::vector<std::string> getValues(const std::string &Key) const
+		{
+			const ValueNode *node = getNode(Key);
+			if (!node)
+			{
+				return std::vector<std::string>();
+			}
+			return node->isArray ? node->Values : std::vector<std::string>(1, node->Value);
+		}
+
+		// text in file, differs from toString() only for interpolated value
+		std::string getRaw(const std::string &Key) const noexcept
 		{
-			if (!_sectionMap.count(Key))
+			const ValueNode *node = getNode(Key);
+			if (!node)
 			{
 				return "";
 			}
-			return _sectionMap[Key].Value;
+			return node->Raw.empty() ? node->Value : node->Raw;
 		}
 
 #ifdef _ENBABLE_INICPP_STD_WSTRING_
-		std::wstring toWString(const std::string &Key)
+		// converted on each call, IniManager::toWString() converts once
+		std::wstring toWString(const std::string &Key) const
 		{
-			std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-			return converter.from_bytes(toString(Key));
+			const ValueNode *node = getNode(Key);
+			return node ? WStringConverter::fromBytes(node->Value) : L"";
 		}
 #endif
 
-		double toDouble(const std::string &Key) noexcept
+		double toDouble(const std::string &Key) const noexcept
 		{
-			if (!_sectionMap.count(Key))
+			const ValueNode *node = getNode(Key);
+			if (!node)
 			{
 				return 0.0;
 			}
@@ -364,25 +1034,25 @@ namespace inicpp
 
 			try
 			{
-				result = std::stod(_sectionMap[Key].Value);
+				result = std::stod(node->Value);
 			}
 			catch (const std::invalid_argument &e)
 			{
-				INI_DEBUG("Invalid argument: " << e.what() << ",input:\'" << _sectionMap[Key].Value << "\'");
+				INI_DEBUG("Invalid argument: " << e.what() << ",input:\'" << node->Value << "\'");
 			}
 			catch (const std::out_of_range &e)
 			{
-				INI_DEBUG("Out of range: " << e.what() << ",input:\'" << _sectionMap[Key].Value << "\'");
+				INI_DEBUG("Out of range: " << e.what() << ",input:\'" << node->Value << "\'");
 			}
 
 			return result;
 		}
 
-		std::map<std::string /*Key*/, std::string /*Value*/> getSectionMap()
+		std::map<std::string /*Key*/, std::string /*Value*/> getSectionMap() const
 		{
 			std::map<std::string /*Key*/, std::string /*Value*/> sectionKVMap;
 
-			for (auto &iter : _sectionMap)
+			for (const auto &iter : _sectionMap)
 			{
 				sectionKVMap[iter.first] = iter.second.Value;
 			}
@@ -391,11 +1061,42 @@ namespace inicpp
 		}
 
 		// Automatically converts to any type; throws std::runtime_error if not found or conversion fails
+		// a missing key is not inserted: the proxy has its own empty value
 		ValueProxy operator[](const std::string &Key)
 		{
-			ValueProxy vp(_sectionMap[Key].Value);
+			auto iter = _sectionMap.find(Key);
+			if (iter == _sectionMap.end())
+			{
+				ValueProxy vp((std::string()));
+				vp.setWriteCB(this, _sectionName, Key);
+				return vp;
+			}
+
+			_isHashValid = false; // value may be changed by ValueProxy
+
+			ValueNode &node = iter->second;
+			ValueProxy vp(node.Value);
 
 			vp.setWriteCB(this, _sectionName, Key);
+			if (node.isArray)
+			{
+				vp.setValues(&node.Values);
+			}
+
+			return vp;
+		}
+
+		// read-only, e.g. a section of IniReader: the const proxy has a copy of the value and can not be assigned
+		const ValueProxy operator[](const std::string &Key) const
+		{
+			const ValueNode *node = getNode(Key);
+			ValueProxy vp(node ? node->Value : std::string());
+
+			vp.setWriteCB(nullptr, _sectionName, Key);
+			if (node && node->isArray)
+			{
+				vp.setValues(&node->Values);
+			}
 
 			return vp;
 		}
@@ -403,10 +1104,20 @@ namespace inicpp
 		inline parentHelper *parent() override { return _parent; };
 		inline void setParent(parentHelper *parent) override { _parent = parent; };
 
+		friend IniDiff diff(const ini &oldSnapshot, const ini &newSnapshot);
+		friend class ini;
+		friend class schema;
+		friend class IniPublisher;
+
 	private:
 		std::string _sectionName;
 		std::map<std::string /*Key*/, ValueNode> _sectionMap;
 		int _lineNumber = -1; // text line start with 1
+		int _endLine = -1;	  // max lineNumber of _sectionMap
+		std::size_t _generation = 0;
+
+		mutable std::size_t _hash = 0;
+		mutable bool _isHashValid = false;
 
 		parentHelper *_parent = nullptr;
 	};
@@ -416,6 +1127,7 @@ namespace inicpp
 	public:
 		void addSection(section &sec)
 		{
+			_isFilterValid = false;
 			if (_iniInfoMap.count(sec.name())) // if exist,need to merge
 			{
 				_iniInfoMap[sec.name()].append(sec);
@@ -425,17 +1137,31 @@ namespace inicpp
 			return;
 		}
 
+		void addSection(section &&sec)
+		{
+			_isFilterValid = false;
+			auto iter = _iniInfoMap.find(sec.name());
+			if (iter != _iniInfoMap.end()) // if exist,need to merge
+			{
+				iter->second.append(sec);
+				return;
+			}
+			std::string sectionName = sec.name();
+			_iniInfoMap.emplace(std::move(sectionName), std::move(sec));
+		}
+
 		void removeSection(const std::string &sectionName)
 		{
 			if (!_iniInfoMap.count(sectionName))
 			{
 				return;
 			}
+			_isFilterValid = false;
 			_iniInfoMap.erase(sectionName);
 			return;
 		}
 
-		bool isSectionExists(const std::string &sectionName)
+		bool isSectionExists(const std::string &sectionName) const
 		{
 			return !_iniInfoMap.count(sectionName) ? false : true;
 		}
@@ -465,16 +1191,13 @@ namespace inicpp
 			return _iniInfoMap[sectionName].getSectionMap();
 		}
 
-		const section &operator[](const std::string &sectionName)
+		// copy of the section, a missing section is not inserted
+		section operator[](const std::string &sectionName)
 		{
-			_iniInfoMap[sectionName].setParent(this);
-
-			if (_iniInfoMap[sectionName].name().empty())
-			{
-				_iniInfoMap[sectionName].setName(sectionName, -1);
-			}
-
-			return _iniInfoMap[sectionName];
+			auto iter = _iniInfoMap.find(sectionName);
+			section sec = iter == _iniInfoMap.end() ? section(sectionName) : iter->second;
+			sec.setParent(this);
+			return sec;
 		}
 
 		inline std::size_t getSectionSize()
@@ -482,456 +1205,3261 @@ namespace inicpp
 			return _iniInfoMap.size();
 		}
 
-		std::string getValue(const std::string &sectionName, const std::string &Key)
+		std::string getValue(const std::string &sectionName, const std::string &Key) const
 		{
-			if (!_iniInfoMap.count(sectionName))
-			{
-				return "";
-			}
-			return _iniInfoMap[sectionName][Key];
+			const ValueNode *node = getNode(sectionName, Key);
+			return node ? node->Value : "";
 		}
 
-		// for none section
-		int getLine(const std::string &Key)
+		// const lookup, never inserts: false if not found or conversion failed
+		template <typename T>
+		bool get(const std::string &sectionName, const std::string &Key, T &result) const
 		{
-			if (!_iniInfoMap.count(""))
+			const ValueNode *node = getNode(sectionName, Key);
+			if (!node)
 			{
-				return -1;
+				return false;
 			}
-			return _iniInfoMap[""].getLine(Key);
-		}
 
-		// for section-key
-		int getLine(const std::string &sectionName, const std::string &Key)
-		{
-			if (!_iniInfoMap.count(sectionName))
+			std::string value = node->Value;
+			ValueProxy proxy(value);
+			if (node->isArray)
 			{
-				return -1;
+				proxy.setValues(&node->Values);
 			}
-			return _iniInfoMap[sectionName].getLine(Key);
-		}
-
-		inline void clear() { _iniInfoMap.clear(); }
-		inline bool empty() { return _iniInfoMap.empty(); }
-
-		parentHelper *parent() override { return _parent; }
-		void setParent(parentHelper *parent) override { _parent = parent; }
 
-	protected:
-		std::map<std::string /*Section Name*/, section> _iniInfoMap;
+			try
+			{
+				result = proxy.get<T>();
+			}
+			catch (const std::runtime_error &e)
+			{
+				INI_DEBUG("ini get failed: " << e.what());
+				return false;
+			}
+			return true;
+		}
 
-	private:
-		parentHelper *_parent = nullptr;
-	};
+		// increased by every reload, the generation of ValueNode/section tells the last change
+		inline std::size_t generation() const { return _generation; }
 
-	class IniManager : parentHelper
-	{
-	public:
-		explicit IniManager(const std::string &configFileName = "") : _configFileName(configFileName)
+		void updateGeneration(const ini &previous)
 		{
-			_iniData.setParent(this);
+			_generation = previous._generation + 1;
 
-			parse();
+			for (auto &data : _iniInfoMap)
+			{
+				auto iter = previous._iniInfoMap.find(data.first);
+				data.second.updateGeneration(iter == previous._iniInfoMap.end() ? nullptr : &iter->second, _generation);
+			}
 		}
 
-		~IniManager()
+		friend IniDiff diff(const ini &oldSnapshot, const ini &newSnapshot);
+		friend class schema;
+		friend class IniPublisher;
+
+		/**
+		 * Replace ${section:key}, ${key} (same section) and ${ENV:NAME} in values.
+		 * Every value is resolved once and kept in ValueNode::Value (text in ValueNode::Raw),
+		 * array values in ValueNode::Values (text in ValueNode::RawValues),
+		 * values of previous are reused unless their text, or any value they refer to, changed.
+		 * Unknown keys are kept as literal ${...}, keys in or depending on a cycle keep their text.
+		 */
+		void interpolate(const ini &previous)
 		{
-			_iniFile.close();
-		}
+			std::list<KeyRef> interpolated;
+			std::set<KeyRef> dirty;
+			std::map<KeyRef, std::list<KeyRef>> dependents;
 
-		section operator[](const std::string &sectionName)
-		{
-			return _iniData[sectionName];
-		}
+			for (auto &sec : _iniInfoMap)
+			{
+				for (auto &data : sec.second._sectionMap)
+				{
+					KeyRef ref(sec.first, data.first);
+					ValueNode &node = data.second;
 
-		void parse()
-		{
-			if (_configFileName.empty())
+					const ValueNode *prev = previous.getNode(sec.first, data.first);
+					if (!prev || (prev->Raw.empty() ? prev->Value : prev->Raw) != node.Value ||
+						(node.isArray && (prev->RawValues.empty() ? prev->Values : prev->RawValues) != node.Values))
+					{
+						dirty.insert(ref);
+					}
+
+					bool isReferring = node.Value.find("${") != std::string::npos;
+					for (std::size_t i = 0; node.isArray && !isReferring && i < node.Values.size(); ++i)
+					{
+						isReferring = node.Values[i].find("${") != std::string::npos;
+					}
+					if (!isReferring)
+					{
+						continue;
+					}
+
+					node.Raw = node.Value;
+					if (node.isArray) // Value is the last of them
+					{
+						node.RawValues = node.Values;
+					}
+					interpolated.push_back(ref);
+
+					auto addReferences = [&](const std::string &text)
+					{
+						forEachReference(text, [&](const std::string &target)
+										 {
+											KeyRef targetRef;
+											if (!splitReference(target, sec.first, targetRef))
+											{
+												dirty.insert(ref); // environment may change at any time
+												return;
+											}
+											dependents[targetRef].push_back(ref); });
+					};
+					addReferences(node.Raw);
+					for (const auto &raw : node.RawValues)
+					{
+						addReferences(raw);
+					}
+				}
+			}
+
+			_isInterpolated = true;
+			if (interpolated.empty())
 			{
 				return;
 			}
 
-			if (!_iniFile.is_open())
+			for (const auto &sec : previous._iniInfoMap) // removed keys
 			{
-				_iniFile.clear();
-				_iniFile.open(_configFileName, std::ifstream::in | std::ifstream::out | std::fstream::app);
+				for (const auto &data : sec.second._sectionMap)
+				{
+					if (!getNode(sec.first, data.first))
+					{
+						dirty.insert(KeyRef(sec.first, data.first));
+					}
+				}
 			}
 
-			if (!_iniFile.is_open())
+			// invalidate dependents of changed keys
+			std::list<KeyRef> pending(dirty.begin(), dirty.end());
+			while (!pending.empty())
 			{
-				INI_DEBUG("Failed to open(WR),try to open with readonly(R).");
-				_iniFile.clear();
-				_iniFile.open(_configFileName, std::ifstream::in);
+				auto iter = dependents.find(pending.front());
+				pending.pop_front();
+				if (iter == dependents.end())
+				{
+					continue;
+				}
+				for (const auto &ref : iter->second)
+				{
+					if (dirty.insert(ref).second)
+					{
+						pending.push_back(ref);
+					}
+				}
 			}
 
-			if (!_iniFile.is_open())
+			std::map<KeyRef, int /*1:resolving 2:resolved 3:cycle*/> state;
+			for (const auto &ref : interpolated)
 			{
-				INI_DEBUG("Failed to open the input INI file for parsing! file:" << _configFileName);
-				return;
+				const ValueNode *prev = previous.getNode(ref.first, ref.second);
+				if (previous._isInterpolated && !dirty.count(ref) && (prev->Value != prev->Raw || (prev->isArray && prev->Values != prev->RawValues))) // unchanged text may still be a cycle
+				{
+					ValueNode *node = findNode(ref);
+					node->Value = prev->Value;
+					if (node->isArray)
+					{
+						node->Values = prev->Values;
+					}
+					node->resetCache();
+					state[ref] = 2;
+				}
 			}
 
-			_iniData.clear();
-
-			_iniFile.seekg(0, _iniFile.beg);
-			std::string data, sectionName;
-			int sectionLine = -1;
+			for (const auto &ref : interpolated)
+			{
+				resolve(ref, state);
+			}
+		}
 
-			section sectionRecord;
+		// key-values in file order: unnamed section first, arrays as key[]=value, interpolated as written
+		void serialize(std::ostream &output) const
+		{
+			std::vector<const std::pair<const std::string, section> *> sections;
+			for (const auto &data : _iniInfoMap)
+			{
+				sections.push_back(&data);
+			}
+			std::stable_sort(sections.begin(), sections.end(), [](const std::pair<const std::string, section> *a, const std::pair<const std::string, section> *b)
+							 { return (a->first == "" ? 0 : a->second._lineNumber) < (b->first == "" ? 0 : b->second._lineNumber); });
 
-			_SumOfLines = 1;
-			do
+			for (const auto *sec : sections)
 			{
-				std::getline(_iniFile, data);
+				std::vector<const std::pair<const std::string, ValueNode> *> keys;
+				for (const auto &data : sec->second._sectionMap)
+				{
+					if (data.second.lineNumber > 0)
+					{
+						keys.push_back(&data);
+					}
+				}
+				std::stable_sort(keys.begin(), keys.end(), [](const std::pair<const std::string, ValueNode> *a, const std::pair<const std::string, ValueNode> *b)
+								 { return (a->second.isArray ? a->second.valueLines[0] : a->second.lineNumber) < (b->second.isArray ? b->second.valueLines[0] : b->second.lineNumber); });
 
-				if (!filterData(data))
+				if (sec->first != "")
 				{
-					++_SumOfLines;
-					continue;
+					output << "[" << sec->first << "]\n";
 				}
 
-				if (data.find('[') == 0) // section
+				for (const auto *key : keys)
 				{
-					if (!sectionRecord.isEmpty() || sectionRecord.name() != "")
+					const ValueNode &node = key->second;
+					// a key read from an indented line, at column 0 it would be a comment or section
+					const char first = !key->first.empty() ? key->first[0] : '\0';
+					const char *indent = (first == ';' || first == '#' || first == '[') ? " " : "";
+					if (!node.isArray)
 					{
-						_iniData.addSection(sectionRecord);
+						output << indent << key->first << "=" << (node.Raw.empty() ? node.Value : node.Raw) << "\n";
+						continue;
 					}
-
-					size_t first = data.find('[');
-					size_t last = data.find(']');
-
-					if (last == std::string::npos)
+					for (const auto &value : node.RawValues.empty() ? node.Values : node.RawValues)
 					{
-						++_SumOfLines;
-						continue;
+						// "[]=" is no array, an unnamed one stays a repeated key
+						output << indent << key->first << (key->first.empty() ? "=" : "[]=") << value << "\n";
 					}
-
-					sectionName = data.substr(first + 1, last - first - 1);
-					sectionLine = _SumOfLines;
-
-					sectionRecord.clear();
-					sectionRecord.setName(sectionName, sectionLine);
-				}
-
-				size_t pos = data.find('=');
-				if (pos != std::string::npos)
-				{ // k=v
-					std::string key = data.substr(0, pos);
-					std::string value = data.substr(pos + 1);
-
-					trimEdges(key);
-					trimEdges(value);
-
-					sectionRecord.setValue(key, value, _SumOfLines);
 				}
+			}
+		}
 
-				++_SumOfLines;
-
-			} while (!_iniFile.eof());
+		// section::getValues() without copy, valid until the data changes
+		const std::vector<std::string> &getValues(const std::string &sectionName, const std::string &Key)
+		{
+			static const std::vector<std::string> empty;
 
-			if (!sectionRecord.isEmpty())
+			ValueNode *node = getNode(sectionName, Key) ? findNode(KeyRef(sectionName, Key)) : nullptr;
+			if (!node)
 			{
-				sectionRecord.setName(sectionName, -1);
-				_iniData.addSection(sectionRecord);
+				return empty;
 			}
-
-			if (_iniFile.is_open())
+			if (!node->isArray && (node->Values.size() != 1 || node->Values[0] != node->Value)) // plain value, kept once
 			{
-				_iniFile.close();
+				node->Values.assign(1, node->Value);
 			}
+			return node->Values;
 		}
 
-		bool set(const std::string &Section, const std::string &Key, const std::string &Value, const std::string &comment = "") override
+#ifdef _ENBABLE_INICPP_STD_WSTRING_
+		// converted once, then cached in the ValueNode until its value changes
+		const std::wstring &toWString(const std::string &sectionName, const std::string &Key)
 		{
-			parse();
-
-			std::string key = Key, value = Value;
+			static const std::wstring empty;
 
-			trimEdges(key);
-			trimEdges(key);
-
-			if (key == "" || value == "")
+			ValueNode *node = getNode(sectionName, Key) ? findNode(KeyRef(sectionName, Key)) : nullptr;
+			if (!node)
 			{
-				INI_DEBUG("Invalid parameter input: key[" << key << "],value[" << value << "]");
-				return false;
+				return empty;
 			}
-
-			std::string keyValueData = key + "=" + value + "\n";
-			if (comment.length() > 0)
+			if (!node->isWValueValid)
 			{
-				keyValueData = comment + "\n" + keyValueData;
-				if (comment[0] != ';')
-				{
-					keyValueData = ";" + keyValueData;
-				}
+				node->WValue = WStringConverter::fromBytes(node->Value);
+				node->isWValueValid = true;
 			}
+			return node->WValue;
+		}
+#endif
 
-			const std::string &tempFile = ".temp.ini";
-			std::fstream input(_configFileName, std::ifstream::in);
-			std::ofstream output(tempFile);
-
-			if (!input.is_open())
+		// nullptr if not found, never insert
+		const ValueNode *getNode(const std::string &sectionName, const std::string &Key) const
+		{
+			if (_isFilterValid && !mayContain(sectionName, Key)) // most misses end here
 			{
-				INI_DEBUG("Failed to open the input INI file for modification! File name:" << _configFileName);
-				return false;
+				return nullptr;
 			}
 
-			if (!output.is_open())
+			auto iter = _iniInfoMap.find(sectionName);
+			if (iter == _iniInfoMap.end())
 			{
-				INI_DEBUG("Failed to open the output INI file for modification!");
-				return false;
+				return nullptr;
 			}
+			return iter->second.getNode(Key);
+		}
 
-			int line_number_mark = -1;
-			bool isInputDataWited = false;
+		// for none section
+		int getLine(const std::string &Key)
+		{
+			if (!_iniInfoMap.count(""))
+			{
+				return -1;
+			}
+			return _iniInfoMap[""].getLine(Key);
+		}
 
-			do
+		// for section-key
+		int getLine(const std::string &sectionName, const std::string &Key)
+		{
+			if (!_iniInfoMap.count(sectionName))
 			{
-				// exist key at one section replace it, or need to create it
-				if (_iniData.isSectionExists(Section))
-				{
-					line_number_mark = (*this)[Section].getLine(key);
+				return -1;
+			}
+			return _iniInfoMap[sectionName].getLine(Key);
+		}
 
-					if (line_number_mark == -1)
-					{ // section exist, key not exist
-						line_number_mark = (*this)[Section].getEndSection();
+		int getEndSection(const std::string &sectionName)
+		{
+			if (!_iniInfoMap.count(sectionName))
+			{
+				return -1;
+			}
+			return _iniInfoMap[sectionName].getEndSection();
+		}
+
+		// line index: byte offset of text line, line start with 1
+		void addLineOffset(std::size_t offset, bool isComment = false)
+		{
+			_lineOffsets.push_back(offset);
+			_commentLines.push_back(isComment);
+		}
+
+		// line start with ';'
+		bool isCommentLine(int line) const
+		{
+			return line >= 1 && static_cast<std::size_t>(line) <= _commentLines.size() && _commentLines[line - 1];
+		}
+
+		// line ends with '\\' and continues on the next line, see Dialect::lineContinuation
+		void markContinued(int line)
+		{
+			if (static_cast<std::size_t>(line) > _continuedLines.size())
+			{
+				_continuedLines.resize(line, false);
+			}
+			_continuedLines[line - 1] = true;
+		}
+
+		// the last text line of a continued line
+		int lastLine(int line) const
+		{
+			while (line >= 1 && static_cast<std::size_t>(line) <= _continuedLines.size() && _continuedLines[line - 1])
+			{
+				++line;
+			}
+			return line;
+		}
+
+		// offset of the line, or the data size if the line is beyond the end
+		std::size_t getLineOffset(int line) const
+		{
+			if (line < 1)
+			{
+				return 0;
+			}
+			if (static_cast<std::size_t>(line) > _lineOffsets.size())
+			{
+				return _dataSize;
+			}
+			return _lineOffsets[line - 1];
+		}
+
+		/**
+		 * Incremental update after IniManager rewrote a few lines, instead of parsing
+		 * the whole file again: setLineIndex(), eraseKey(), remapLines(), then merge().
+		 */
+		inline const std::vector<std::size_t> &lineOffsets() const { return _lineOffsets; }
+		inline bool hasContinuedLines() const { return !_continuedLines.empty(); }
+		inline std::size_t nextGeneration() { return ++_generation; }
+
+		void setLineIndex(std::vector<std::size_t> &offsets, std::vector<bool> &comments, std::size_t dataSize)
+		{
+			_lineOffsets.swap(offsets);
+			_commentLines.swap(comments);
+			_dataSize = dataSize;
+		}
+
+		// the key and its lines are removed
+		void eraseKey(const std::string &sectionName, const std::string &Key, std::size_t generation)
+		{
+			auto iter = _iniInfoMap.find(sectionName);
+			if (iter == _iniInfoMap.end() || !iter->second._sectionMap.erase(Key))
+			{
+				return;
+			}
+
+			iter->second._isHashValid = false;
+			iter->second._generation = generation;
+			if (sectionName == "" && iter->second.isEmpty()) // as parse(): no empty unnamed section
+			{
+				_iniInfoMap.erase(iter);
+			}
+		}
+
+		// lineMap[old line] is the new line
+		void remapLines(const std::vector<int> &lineMap)
+		{
+			auto remap = [&lineMap](int line)
+			{
+				return line >= 1 && static_cast<std::size_t>(line) < lineMap.size() ? lineMap[line] : line;
+			};
+
+			int firstChanged = 1;
+			while (static_cast<std::size_t>(firstChanged) < lineMap.size() && lineMap[firstChanged] == firstChanged)
+			{
+				++firstChanged;
+			}
+
+			for (auto &sec : _iniInfoMap)
+			{
+				section &data = sec.second;
+				if (data._lineNumber < firstChanged && data._endLine < firstChanged) // before every edit
+				{
+					continue;
+				}
+
+				data._lineNumber = remap(data._lineNumber);
+				data._endLine = -1;
+				for (auto &key : data._sectionMap)
+				{
+					ValueNode &node = key.second;
+					node.lineNumber = remap(node.lineNumber);
+					for (auto &line : node.valueLines)
+					{
+						line = remap(line);
+					}
+					data._endLine = std::max(data._endLine, node.lineNumber);
+				}
+			}
+		}
+
+		// add the key-values of text parsed alone as lines from firstLine, keys before any [section] go to sectionName
+		void merge(ini &text, int firstLine, const std::string &sectionName, std::size_t generation)
+		{
+			const int shift = firstLine - 1;
+			for (auto &sec : text._iniInfoMap)
+			{
+				const std::string &name = sec.first == "" ? sectionName : sec.first;
+				auto iter = _iniInfoMap.find(name);
+				if (iter == _iniInfoMap.end())
+				{
+					iter = _iniInfoMap.emplace(name, section()).first;
+					iter->second.setName(name, sec.first == "" ? -1 : sec.second._lineNumber + shift);
+				}
+
+				section &target = iter->second;
+				for (const auto &key : sec.second._sectionMap)
+				{
+					const ValueNode &node = key.second;
+					if (!node.isArray)
+					{
+						target.addValue(key.first, node.Value, node.lineNumber + shift);
+					}
+					for (std::size_t i = 0; node.isArray && i < node.Values.size(); ++i)
+					{
+						target.addValue(key.first, node.Values[i], node.valueLines[i] + shift, true);
+					}
+					target._sectionMap[key.first].generation = generation;
+					addToFilter(name, key.first);
+				}
+				target._generation = generation;
+			}
+		}
+
+		// Bloom filter of all section-keys for getNode(), built at the end of parse
+		void buildFilter()
+		{
+			std::size_t count = 0;
+			for (const auto &sec : _iniInfoMap)
+			{
+				count += sec.second._sectionMap.size();
+			}
+
+			std::size_t words = 1;
+			while (words * 64 < count * 10) // 10 bits per key: about 1% false positive
+			{
+				words <<= 1;
+			}
+			_filter.assign(words, 0);
+
+			std::hash<std::string> hasher;
+			for (const auto &sec : _iniInfoMap)
+			{
+				std::uint64_t sectionHash = hasher(sec.first);
+				for (const auto &data : sec.second._sectionMap)
+				{
+					std::uint64_t hash = filterHash(sectionHash, hasher(data.first));
+					for (int i = 0; i < FILTER_HASHES; ++i)
+					{
+						std::uint64_t bit = filterBit(hash, i);
+						_filter[bit >> 6] |= 1ULL << (bit & 63);
+					}
+				}
+			}
+			_isFilterValid = true;
+		}
+
+		inline void setDataSize(std::size_t size) { _dataSize = size; }
+		inline std::size_t getDataSize() const { return _dataSize; }
+
+		inline void clear()
+		{
+			_iniInfoMap.clear();
+			_lineOffsets.clear();
+			_commentLines.clear();
+			_continuedLines.clear();
+			_filter.clear();
+			_isFilterValid = false;
+			_dataSize = 0;
+			_isInterpolated = false;
+		}
+		inline bool empty() { return _iniInfoMap.empty(); }
+
+		parentHelper *parent() override { return _parent; }
+		void setParent(parentHelper *parent) override { _parent = parent; }
+
+	protected:
+		std::map<std::string /*Section Name*/, section> _iniInfoMap;
+
+	private:
+		typedef std::pair<std::string /*Section*/, std::string /*Key*/> KeyRef;
+
+		ValueNode *findNode(const KeyRef &ref)
+		{
+			auto iter = _iniInfoMap.find(ref.first);
+			if (iter == _iniInfoMap.end())
+			{
+				return nullptr;
+			}
+			auto node = iter->second._sectionMap.find(ref.second);
+			return node == iter->second._sectionMap.end() ? nullptr : &node->second;
+		}
+
+		// call func with the text between each "${" and "}"
+		template <typename Func>
+		static void forEachReference(const std::string &raw, Func func)
+		{
+			std::size_t begin = raw.find("${");
+			while (begin != std::string::npos)
+			{
+				std::size_t end = raw.find('}', begin + 2);
+				if (end == std::string::npos)
+				{
+					return;
+				}
+				func(raw.substr(begin + 2, end - begin - 2));
+				begin = raw.find("${", end + 1);
+			}
+		}
+
+		// false for ENV:NAME
+		static bool splitReference(const std::string &target, const std::string &sectionName, KeyRef &ref)
+		{
+			std::size_t pos = target.rfind(':');
+			if (pos == std::string::npos)
+			{
+				ref = KeyRef(sectionName, target);
+				return true;
+			}
+			if (target.compare(0, pos, "ENV") == 0 && pos == 3)
+			{
+				return false;
+			}
+			ref = KeyRef(target.substr(0, pos), target.substr(pos + 1));
+			return true;
+		}
+
+		// false if not found, in a cycle or depending on one (state 3, Value stays Raw)
+		bool resolve(const KeyRef &ref, std::map<KeyRef, int> &state)
+		{
+			ValueNode *node = findNode(ref);
+			if (!node)
+			{
+				return false;
+			}
+			if (node->Raw.empty() && node->RawValues.empty())
+			{
+				return true;
+			}
+
+			int &status = state[ref];
+			if (status == 2)
+			{
+				return true;
+			}
+			if (status == 1)
+			{
+				INI_DEBUG("Interpolation cycle at: " << ref.first << "-" << ref.second);
+				status = 3; // every key back to here sees it and fails as well
+				return false;
+			}
+			if (status == 3)
+			{
+				return false;
+			}
+			status = 1;
+
+			auto resolveText = [&](const std::string &raw) -> std::string
+			{
+				std::string result;
+				std::size_t last = 0;
+				forEachReference(raw, [&](const std::string &target)
+								 {
+									std::size_t begin = raw.find("${" + target + "}", last);
+									result.append(raw, last, begin - last);
+									last = begin + target.length() + 3;
+
+									KeyRef targetRef;
+									if (!splitReference(target, ref.first, targetRef))
+									{
+										const char *env = std::getenv(target.c_str() + 4);
+										result += env ? env : "";
+									}
+									else if (resolve(targetRef, state))
+									{
+										result += findNode(targetRef)->Value;
+									}
+									else
+									{
+										auto found = state.find(targetRef);
+										if (found != state.end() && found->second == 3)
+										{
+											status = 3;
+										}
+										result += "${" + target + "}";
+									} });
+				result.append(raw, last, std::string::npos);
+				return result;
+			};
+
+			std::string result = resolveText(node->Raw);
+			std::vector<std::string> results;
+			for (const auto &raw : node->RawValues)
+			{
+				results.push_back(resolveText(raw));
+			}
+
+			node->Value = status == 3 ? node->Raw : result;
+			if (!node->RawValues.empty())
+			{
+				node->Values = status == 3 ? node->RawValues : results;
+			}
+			node->resetCache();
+			if (status == 3)
+			{
+				return false;
+			}
+			status = 2;
+			return true;
+		}
+
+		std::vector<std::size_t> _lineOffsets;
+		std::vector<bool> _commentLines;
+		std::vector<bool> _continuedLines; // empty without line continuation
+
+		static const int FILTER_HASHES = 3;
+		std::vector<std::uint64_t> _filter; // see buildFilter()
+		bool _isFilterValid = false;		// invalid after the sections changed
+
+		static std::uint64_t filterHash(std::uint64_t sectionHash, std::uint64_t keyHash)
+		{
+			std::uint64_t hash = (keyHash * 0x9e3779b97f4a7c15ULL) ^ sectionHash;
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdULL;
+			return hash ^ (hash >> 33);
+		}
+
+		// i-th bit of hash, by double hashing
+		std::uint64_t filterBit(std::uint64_t hash, int i) const
+		{
+			return (hash + static_cast<std::uint64_t>(i) * ((hash >> 32) | 1)) & (_filter.size() * 64 - 1);
+		}
+
+		void addToFilter(const std::string &sectionName, const std::string &Key)
+		{
+			if (!_isFilterValid)
+			{
+				return;
+			}
+
+			std::hash<std::string> hasher;
+			std::uint64_t hash = filterHash(hasher(sectionName), hasher(Key));
+			for (int i = 0; i < FILTER_HASHES; ++i)
+			{
+				std::uint64_t bit = filterBit(hash, i);
+				_filter[bit >> 6] |= 1ULL << (bit & 63);
+			}
+		}
+
+		bool mayContain(const std::string &sectionName, const std::string &Key) const
+		{
+			std::hash<std::string> hasher;
+			std::uint64_t hash = filterHash(hasher(sectionName), hasher(Key));
+			for (int i = 0; i < FILTER_HASHES; ++i)
+			{
+				std::uint64_t bit = filterBit(hash, i);
+				if (!(_filter[bit >> 6] & (1ULL << (bit & 63))))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		std::size_t _dataSize = 0;
+		std::size_t _generation = 0;
+		bool _isInterpolated = false;
+
+		parentHelper *_parent = nullptr;
+	};
+
+	/**
+	 * Added, removed and modified section-keys from oldSnapshot to newSnapshot.
+	 * Sections with the same content hash are skipped without comparing keys.
+	 */
+	inline IniDiff diff(const ini &oldSnapshot, const ini &newSnapshot)
+	{
+		IniDiff result;
+
+		auto addAll = [](std::list<IniDiff::Entry> &entries, const std::string &sectionName, const section &sec)
+		{
+			for (const auto &data : sec._sectionMap)
+			{
+				entries.emplace_back(sectionName, data.first);
+			}
+		};
+
+		auto oldIter = oldSnapshot._iniInfoMap.begin(), oldEnd = oldSnapshot._iniInfoMap.end();
+		auto newIter = newSnapshot._iniInfoMap.begin(), newEnd = newSnapshot._iniInfoMap.end();
+
+		while (oldIter != oldEnd || newIter != newEnd)
+		{
+			if (newIter == newEnd || (oldIter != oldEnd && oldIter->first < newIter->first))
+			{
+				addAll(result.removed, oldIter->first, oldIter->second);
+				++oldIter;
+				continue;
+			}
+
+			if (oldIter == oldEnd || newIter->first < oldIter->first)
+			{
+				addAll(result.added, newIter->first, newIter->second);
+				++newIter;
+				continue;
+			}
+
+			const section &oldSection = oldIter->second, &newSection = newIter->second;
+			if (oldSection.hash() != newSection.hash())
+			{
+				auto oldKey = oldSection._sectionMap.begin(), oldKeyEnd = oldSection._sectionMap.end();
+				auto newKey = newSection._sectionMap.begin(), newKeyEnd = newSection._sectionMap.end();
+
+				while (oldKey != oldKeyEnd || newKey != newKeyEnd)
+				{
+					if (newKey == newKeyEnd || (oldKey != oldKeyEnd && oldKey->first < newKey->first))
+					{
+						result.removed.emplace_back(oldIter->first, (oldKey++)->first);
+					}
+					else if (oldKey == oldKeyEnd || newKey->first < oldKey->first)
+					{
+						result.added.emplace_back(newIter->first, (newKey++)->first);
+					}
+					else
+					{
+						if (!oldKey->second.isSameValue(newKey->second))
+						{
+							result.modified.emplace_back(newIter->first, newKey->first);
+						}
+						++oldKey;
+						++newKey;
+					}
+				}
+			}
+
+			++oldIter;
+			++newIter;
+		}
+
+		return result;
+	}
+
+	// violation found by schema::validate()
+	typedef struct ValidationError
+	{
+		std::string section, key;
+		int lineNumber; // text line start with 1, -1 for missing key
+		std::string message;
+	} ValidationError;
+
+	/**
+	 * Rules of section-keys, checked against a parsed ini in one pass:
+	 *   inicpp::schema rules;
+	 *   rules.key("server", "port").required().type(inicpp::schema::Int).range(1, 65535);
+	 *   rules.key("server", "mode").oneOf({"active", "standby"});
+	 *   rules.key("server", "name").match("[a-z][a-z0-9_]*");
+	 *   std::list<inicpp::ValidationError> errors = _ini.validate(rules);
+	 * Every value of an array is checked. Keys without rule are not checked.
+	 */
+	class schema
+	{
+	public:
+		enum Type
+		{
+			String,
+			Int,
+			Double,
+			Bool // 0/1, true/false, yes/no, on/off
+		};
+
+		class rule
+		{
+		public:
+			rule &required(bool isRequired = true)
+			{
+				_isRequired = isRequired;
+				return *this;
+			}
+
+			rule &type(Type valueType)
+			{
+				_type = valueType;
+				return *this;
+			}
+
+			// for Int and Double, also sets the type to Double if it is String
+			rule &range(double minimum, double maximum)
+			{
+				if (_type == String)
+				{
+					_type = Double;
+				}
+				_hasRange = true;
+				_minimum = minimum;
+				_maximum = maximum;
+				return *this;
+			}
+
+			rule &oneOf(const std::set<std::string> &values)
+			{
+				_values = values;
+				return *this;
+			}
+
+			// whole value must match, compiled here once
+			rule &match(const std::string &pattern)
+			{
+				_pattern = pattern;
+				_regex = std::make_shared<std::regex>(pattern);
+				return *this;
+			}
+
+		private:
+			friend class schema;
+
+			// empty if passed
+			std::string check(const std::string &value) const
+			{
+				double number = 0.0;
+
+				switch (_type)
+				{
+				case Int:
+				{
+					char *end = nullptr;
+					errno = 0;
+					long long integer = std::strtoll(value.c_str(), &end, 10);
+					if (value.empty() || *end != '\0' || errno == ERANGE)
+					{
+						return "not an integer: '" + value + "'";
+					}
+					number = static_cast<double>(integer);
+					break;
+				}
+				case Double:
+				{
+					char *end = nullptr;
+					errno = 0;
+					number = std::strtod(value.c_str(), &end);
+					if (value.empty() || *end != '\0' || errno == ERANGE)
+					{
+						return "not a number: '" + value + "'";
+					}
+					break;
+				}
+				case Bool:
+				{
+					static const std::set<std::string> booleans = {"0", "1", "true", "false", "yes", "no", "on", "off"};
+					if (!booleans.count(value))
+					{
+						return "not a boolean: '" + value + "'";
+					}
+					break;
+				}
+				default:
+					break;
+				}
+
+				if (_hasRange && (number < _minimum || number > _maximum))
+				{
+					return "out of range [" + ValueProxy::to_string(_minimum) + ", " + ValueProxy::to_string(_maximum) + "]: '" + value + "'";
+				}
+
+				if (!_values.empty() && !_values.count(value))
+				{
+					return "not one of the allowed values: '" + value + "'";
+				}
+
+				if (_regex && !std::regex_match(value, *_regex))
+				{
+					return "not match '" + _pattern + "': '" + value + "'";
+				}
+
+				return "";
+			}
+
+		private:
+			bool _isRequired = false;
+			Type _type = String;
+			bool _hasRange = false;
+			double _minimum = 0.0, _maximum = 0.0;
+			std::set<std::string> _values;
+			std::string _pattern;
+			std::shared_ptr<std::regex> _regex;
+		};
+
+		// rule of the section-key, created if not exist
+		rule &key(const std::string &Section, const std::string &Key)
+		{
+			return _rules[Section][Key];
+		}
+
+		// all violations, sorted by section and key
+		std::list<ValidationError> validate(const ini &data) const
+		{
+			std::list<ValidationError> errors;
+			static const std::map<std::string, ValueNode> noKeys;
+
+			// both maps are sorted by name: walk them side by side
+			auto sectionRule = _rules.begin();
+			auto sectionData = data._iniInfoMap.begin();
+
+			while (sectionRule != _rules.end())
+			{
+				while (sectionData != data._iniInfoMap.end() && sectionData->first < sectionRule->first)
+				{
+					++sectionData;
+				}
+
+				const bool isSectionFound = sectionData != data._iniInfoMap.end() && sectionData->first == sectionRule->first;
+				const std::map<std::string, ValueNode> &keys = isSectionFound ? sectionData->second._sectionMap : noKeys;
+
+				auto keyRule = sectionRule->second.begin();
+				auto keyData = keys.begin();
+
+				for (; keyRule != sectionRule->second.end(); ++keyRule)
+				{
+					while (keyData != keys.end() && keyData->first < keyRule->first)
+					{
+						++keyData;
+					}
+
+					if (keyData == keys.end() || keyData->first != keyRule->first || keyData->second.lineNumber < 0)
+					{
+						if (keyRule->second._isRequired)
+						{
+							errors.push_back(ValidationError{sectionRule->first, keyRule->first, -1, "required key is missing"});
+						}
+						continue;
+					}
+
+					const ValueNode &node = keyData->second;
+					if (!node.isArray)
+					{
+						checkValue(keyRule->second, sectionRule->first, keyRule->first, node.Value, node.lineNumber, errors);
+						continue;
+					}
+
+					for (std::size_t i = 0; i < node.Values.size(); ++i)
+					{
+						checkValue(keyRule->second, sectionRule->first, keyRule->first, node.Values[i], node.valueLines[i], errors);
+					}
+				}
+
+				++sectionRule;
+			}
+
+			return errors;
+		}
+
+	private:
+		static void checkValue(const rule &keyRule, const std::string &Section, const std::string &Key, const std::string &value, int line, std::list<ValidationError> &errors)
+		{
+			std::string message = keyRule.check(value);
+			if (!message.empty())
+			{
+				errors.push_back(ValidationError{Section, Key, line, message});
+			}
+		}
+
+	private:
+		std::map<std::string /*Section*/, std::map<std::string /*Key*/, rule>> _rules;
+	};
+
+	// size, mtime and inode of a read file: set() skips parse of an unchanged file
+	typedef struct FileState
+	{
+		std::uint64_t size = 0, mtime = 0, inode = 0;
+		bool isValid = false;
+
+		bool operator==(const FileState &other) const
+		{
+			return isValid && other.isValid && size == other.size && mtime == other.mtime && inode == other.inode;
+		}
+	} FileState;
+
+	/**
+	 * Features of the ini dialect, all off by default: plain ini as written by IniManager.
+	 * Parsers are compiled per dialect, disabled features cost nothing. Enable some:
+	 *   struct MyDialect : inicpp::DefaultDialect
+	 *   {
+	 *       static const bool inlineComments = true;
+	 *       static const bool colonSeparator = true;
+	 *   };
+	 *   inicpp::BasicIniManager<MyDialect> _ini("config.ini");
+	 */
+	struct DefaultDialect
+	{
+		static const bool inlineComments = false;	// key=value ;comment, ';' or '#' after a space
+		static const bool colonSeparator = false;	// key: value, split at the first '=' or ':'
+		static const bool quotedValues = false;		// key=" value ", quotes removed and spaces kept
+		static const bool lineContinuation = false; // value ending with '\\' continues on the next line
+		static const bool indentedLines = false;	// [section] and comments after spaces
+	};
+
+	/**
+	 * Tokenizer of ini text, shared by every way of parsing. feed() takes the text in
+	 * chunks of any size, a line may be split between chunks. Also builds the line index.
+	 */
+	template <typename Dialect>
+	class BasicIniParser
+	{
+	public:
+		explicit BasicIniParser(ini &data) : _iniData(data)
+		{
+			_iniData.clear();
+		}
+
+		void feed(const char *data, std::size_t size)
+		{
+			const char *end = data + size;
+			while (data < end)
+			{
+				const char *newLine = static_cast<const char *>(std::memchr(data, '\n', end - data));
+				if (!newLine)
+				{
+					_partial.append(data, end);
+					return;
+				}
+
+				if (_partial.empty())
+				{
+					_line.assign(data, newLine);
+				}
+				else
+				{
+					_partial.append(data, newLine);
+					_line.swap(_partial);
+					_partial.clear();
+				}
+				parseLine(true);
+				data = newLine + 1;
+			}
+		}
+
+		// the last line, without '\n'
+		void finish()
+		{
+			_line.swap(_partial);
+			_partial.clear();
+			parseLine(false);
+
+			_iniData.setDataSize(_offset);
+
+			if (!_sectionRecord.isEmpty() || _sectionRecord.name() != "") // the last section, even without keys
+			{
+				_iniData.addSection(std::move(_sectionRecord));
+			}
+		}
+
+		typedef enum Compression
+		{
+			NONE,
+			GZIP,
+			ZSTD
+		} Compression;
+
+		// by magic bytes
+		static Compression compression(const char *text, std::size_t size)
+		{
+			if (size >= 2 && text[0] == '\x1f' && text[1] == '\x8b')
+			{
+				return GZIP;
+			}
+			if (size >= 4 && std::memcmp(text, "\x28\xb5\x2f\xfd", 4) == 0)
+			{
+				return ZSTD;
+			}
+			return NONE;
+		}
+
+		/**
+		 * Replace the content of iniData with text, keep generations of unchanged values.
+		 * gzip/zstd text is decompressed in chunks into the parser, never as a whole.
+		 * false and iniData unchanged if compressed text is broken or not enabled.
+		 */
+		static bool load(ini &iniData, const char *text, std::size_t size, bool isInterpolation)
+		{
+			TraceSpan span("parse");
+
+			ini previous(std::move(iniData));
+
+			BasicIniParser parser(iniData);
+			bool isLoaded = true;
+			switch (compression(text, size))
+			{
+			case GZIP:
+				isLoaded = feedGzip(parser, text, size);
+				break;
+			case ZSTD:
+				isLoaded = feedZstd(parser, text, size);
+				break;
+			default:
+				parser.feed(text, size);
+				break;
+			}
+
+			if (!isLoaded)
+			{
+				iniData = std::move(previous);
+				return false;
+			}
+			parser.finish();
+			iniData.buildFilter();
+
+			if (isInterpolation)
+			{
+				iniData.interpolate(previous);
+			}
+			iniData.updateGeneration(previous);
+			return true;
+		}
+
+		/**
+		 * Whole file with one read-only open and one read, the file is closed before return.
+		 * A file not exist is an empty config; false for other errors.
+		 */
+		static bool readFile(const std::string &fileName, std::string &data, FileState *state = nullptr)
+		{
+			TraceSpan span("read");
+
+			data.clear();
+			if (state)
+			{
+				state->isValid = false;
+			}
+#ifdef INICPP_POSIX_IO
+			int fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				return errno == ENOENT;
+			}
+
+			struct stat info;
+			bool isRead = ::fstat(fd, &info) == 0;
+			if (isRead && state)
+			{
+				*state = fileState(info);
+			}
+			if (isRead && info.st_size > 0)
+			{
+				data.resize(static_cast<std::size_t>(info.st_size));
+				std::size_t length = 0;
+				while (length < data.length())
+				{
+					ssize_t got = ::read(fd, &data[length], data.length() - length);
+					if (got < 0 && errno == EINTR)
+					{
+						continue;
+					}
+					if (got <= 0)
+					{
+						isRead = got == 0; // file became shorter
+						break;
+					}
+					length += static_cast<std::size_t>(got);
+				}
+				data.resize(length);
+			}
+
+			::close(fd);
+			return isRead;
+#else
+			errno = 0;
+			std::ifstream input(fileName, std::ifstream::in | std::ifstream::binary);
+			if (!input.is_open())
+			{
+				return errno == ENOENT;
+			}
+
+			std::ostringstream buffer;
+			buffer << input.rdbuf();
+			data = buffer.str();
+			return !input.bad();
+#endif
+		}
+
+#ifdef INICPP_POSIX_IO
+		static FileState fileState(const struct stat &info)
+		{
+			FileState state;
+			state.size = static_cast<std::uint64_t>(info.st_size);
+#ifdef __APPLE__
+			state.mtime = static_cast<std::uint64_t>(info.st_mtimespec.tv_sec) * 1000000000ULL + info.st_mtimespec.tv_nsec;
+#else
+			state.mtime = static_cast<std::uint64_t>(info.st_mtim.tv_sec) * 1000000000ULL + info.st_mtim.tv_nsec;
+#endif
+			state.inode = static_cast<std::uint64_t>(info.st_ino);
+			state.isValid = true;
+			return state;
+		}
+#endif
+
+		// line from begin: false if empty or a comment
+		static bool filterData(const std::string &data, std::size_t begin)
+		{
+			if (begin >= data.length())
+			{
+				return false;
+			}
+
+			if (data[begin] == ';')
+			{
+				return false;
+			}
+
+			if (data[begin] == '#')
+			{
+				return false;
+			}
+
+			return true;
+		}
+
+		static void trimEdges(std::string &data)
+		{
+			// remove left ' ' and '\t'
+			data.erase(data.begin(), std::find_if(data.begin(), data.end(), [](unsigned char c)
+												  { return !std::isspace(c); }));
+			// remove right ' ' and '\t'
+			data.erase(std::find_if(data.rbegin(), data.rend(), [](unsigned char c)
+									{ return !std::isspace(c); })
+						   .base(),
+					   data.end());
+		}
+
+	private:
+		void parseLine(bool hasNewLine)
+		{
+			std::size_t begin = 0;
+			if (Dialect::indentedLines)
+			{
+				begin = _line.find_first_not_of(" \t");
+				begin = begin == std::string::npos ? _line.length() : begin;
+			}
+
+			_iniData.addLineOffset(_offset, begin < _line.length() && _line[begin] == ';'); // for line _SumOfLines
+			_offset += _line.length() + (hasNewLine ? 1 : 0);
+
+			int lineNumber = _SumOfLines++;
+
+			if (Dialect::lineContinuation && !joinLines(begin, lineNumber, hasNewLine))
+			{
+				return; // continued on the next line
+			}
+
+			const std::string &data = _line;
+
+			if (!filterData(data, begin))
+			{
+				return;
+			}
+
+			if (data[begin] == '[') // section
+			{
+				size_t first = begin;
+				size_t last = data.find(']', first);
+
+				if (last == std::string::npos) // not a section: ignore the line, keep the current section
+				{
+					INI_DEBUG("Invalid section line " << lineNumber << ": " << data);
+					return;
+				}
+
+				if (!_sectionRecord.isEmpty() || _sectionRecord.name() != "")
+				{
+					_iniData.addSection(std::move(_sectionRecord));
+				}
+
+				_sectionRecord.clear();
+				_sectionRecord.setName(data.substr(first + 1, last - first - 1), lineNumber);
+				return; // anything after ']' is not a key-value
+			}
+
+			size_t pos = Dialect::colonSeparator ? data.find_first_of("=:") : data.find('=');
+			if (pos != std::string::npos)
+			{ // k=v
+				std::string key = data.substr(0, pos);
+				std::string value = data.substr(pos + 1);
+
+				trimEdges(key);
+				if (!(Dialect::quotedValues || Dialect::inlineComments) || !filterValue(value))
+				{
+					trimEdges(value); // spaces in quotes are kept
+				}
+
+				bool isArray = key.length() > 2 && key.compare(key.length() - 2, 2, "[]") == 0; // key[]=value
+				if (isArray)
+				{
+					key.erase(key.length() - 2);
+					trimEdges(key);
+				}
+
+				_sectionRecord.addValue(key, value, lineNumber, isArray);
+			}
+		}
+
+		static const std::size_t CHUNK_SIZE = 64 * 1024; // decompressed text per feed()
+
+		static bool feedGzip(BasicIniParser &parser, const char *text, std::size_t size)
+		{
+#ifdef INICPP_ENABLE_ZLIB
+			z_stream stream;
+			std::memset(&stream, 0, sizeof(stream));
+			if (inflateInit2(&stream, 15 + 16) != Z_OK) // gzip header only
+			{
+				return false;
+			}
+
+			std::vector<char> buffer(CHUNK_SIZE);
+			const unsigned char *input = reinterpret_cast<const unsigned char *>(text);
+			std::size_t rest = size;
+			int result = Z_OK;
+
+			while (result != Z_STREAM_END || stream.avail_in > 0 || rest > 0)
+			{
+				if (result == Z_STREAM_END)
+				{
+					inflateReset(&stream); // next member of concatenated gzip
+				}
+
+				if (stream.avail_in == 0 && rest > 0) // avail_in is 32 bits
+				{
+					stream.next_in = const_cast<unsigned char *>(input + (size - rest));
+					stream.avail_in = static_cast<uInt>(std::min<std::size_t>(rest, 1u << 30));
+					rest -= stream.avail_in;
+				}
+
+				stream.next_out = reinterpret_cast<unsigned char *>(buffer.data());
+				stream.avail_out = static_cast<uInt>(buffer.size());
+
+				result = inflate(&stream, Z_NO_FLUSH);
+				if (result != Z_OK && result != Z_STREAM_END)
+				{
+					INI_DEBUG("Broken gzip config: " << (stream.msg ? stream.msg : "truncated"));
+					break;
+				}
+
+				parser.feed(buffer.data(), buffer.size() - stream.avail_out);
+			}
+
+			inflateEnd(&stream);
+			return result == Z_STREAM_END;
+#else
+			(void)parser;
+			(void)text;
+			(void)size;
+			INI_DEBUG("gzip config: define INICPP_ENABLE_ZLIB and link with -lz");
+			return false;
+#endif
+		}
+
+		static bool feedZstd(BasicIniParser &parser, const char *text, std::size_t size)
+		{
+#ifdef INICPP_ENABLE_ZSTD
+			ZSTD_DStream *stream = ZSTD_createDStream();
+			if (!stream)
+			{
+				return false;
+			}
+			ZSTD_initDStream(stream);
+
+			std::vector<char> buffer(CHUNK_SIZE);
+			ZSTD_inBuffer input = {text, size, 0};
+			std::size_t result = 0;
+			bool isFull = false;
+
+			while (input.pos < input.size || isFull) // a full buffer may have more to flush
+			{
+				ZSTD_outBuffer output = {buffer.data(), buffer.size(), 0};
+				result = ZSTD_decompressStream(stream, &output, &input);
+				if (ZSTD_isError(result))
+				{
+					INI_DEBUG("Broken zstd config: " << ZSTD_getErrorName(result));
+					break;
+				}
+
+				parser.feed(buffer.data(), output.pos);
+				isFull = output.pos == output.size;
+			}
+
+			ZSTD_freeDStream(stream);
+			return !ZSTD_isError(result) && result == 0; // 0: the last frame is complete
+#else
+			(void)parser;
+			(void)text;
+			(void)size;
+			INI_DEBUG("zstd config: define INICPP_ENABLE_ZSTD and link with -lzstd");
+			return false;
+#endif
+		}
+
+		/**
+		 * Collect a key-value line ending with '\\' and its next lines into _line.
+		 * false while the line continues; lineNumber is then the first line.
+		 */
+		bool joinLines(std::size_t begin, int &lineNumber, bool hasNewLine)
+		{
+			std::size_t last = _line.find_last_not_of(" \t\r");
+			bool isContinued = last != std::string::npos && _line[last] == '\\';
+
+			if (_continuedLine == 0)
+			{
+				if (!isContinued || !filterData(_line, begin) || _line[begin] == '[')
+				{
+					return true; // common case: not continued
+				}
+				_continuedLine = lineNumber;
+				_continued.assign(_line, 0, last);
+			}
+			else
+			{
+				_iniData.markContinued(lineNumber - 1);
+				std::size_t first = _line.find_first_not_of(" \t");
+				if (first != std::string::npos && first < (isContinued ? last : _line.length()))
+				{
+					_continued.append(_line, first, (isContinued ? last : _line.length()) - first);
+				}
+			}
+
+			if (isContinued && hasNewLine)
+			{
+				return false;
+			}
+
+			_line.swap(_continued);
+			lineNumber = _continuedLine;
+			_continuedLine = 0;
+			return true;
+		}
+
+		// remove quotes or inline comment of value, true if quoted
+		static bool filterValue(std::string &value)
+		{
+			std::size_t first = value.find_first_not_of(" \t");
+			if (first == std::string::npos)
+			{
+				return false;
+			}
+
+			if (Dialect::quotedValues && value[first] == '"')
+			{
+				std::size_t last = value.find('"', first + 1);
+				if (last != std::string::npos) // anything after the closing quote is ignored
+				{
+					value = value.substr(first + 1, last - first - 1);
+					return true;
+				}
+			}
+
+			if (Dialect::inlineComments)
+			{
+				for (std::size_t i = first; i < value.length(); ++i)
+				{
+					if ((value[i] == ';' || value[i] == '#') && (i == first || value[i - 1] == ' ' || value[i - 1] == '\t'))
+					{
+						value.erase(i);
+						break;
+					}
+				}
+			}
+			return false;
+		}
+
+	private:
+		ini &_iniData;
+		section _sectionRecord;
+		std::string _line, _partial;
+		std::string _continued; // lineContinuation only
+		int _continuedLine = 0;
+		std::size_t _offset = 0;
+		int _SumOfLines = 1;
+	};
+
+	typedef BasicIniParser<DefaultDialect> IniParser;
+
+	/**
+	 * Precompiled accessor of one section-key, for reading config in hot loops:
+	 *   inicpp::handle<int> port = _ini.bind<int>("server", "port");
+	 *   int p = port.get();
+	 * get() returns the cached value and only looks up and converts again when the
+	 * data has been reloaded since. Never throws: a missing key or a conversion
+	 * error gives T() and isValid() false. Must not outlive its IniManager/IniReader.
+	 */
+	template <typename T>
+	class handle
+	{
+	public:
+		handle() : _value() {}
+
+		handle(const ini &data, const std::string &sectionName, const std::string &keyName)
+			: _data(&data), _sectionName(sectionName), _keyName(keyName), _value()
+		{
+		}
+
+		const T &get() const
+		{
+			if (_data && _generation != _data->generation())
+			{
+				resolve();
+			}
+			return _value;
+		}
+
+		operator const T &() const { return get(); }
+
+		// key exists and value converted
+		bool isValid() const
+		{
+			get();
+			return _isValid;
+		}
+
+		// line of the key in the config file, -1 if not found
+		int lineNumber() const
+		{
+			get();
+			return _node ? _node->lineNumber : -1;
+		}
+
+	private:
+		void resolve() const
+		{
+			_generation = _data->generation();
+			_node = _data->getNode(_sectionName, _keyName);
+			_value = T();
+			_isValid = false;
+
+			if (!_node)
+			{
+				INI_DEBUG("handle bind to not exist key: " << _sectionName << "-" << _keyName);
+				return;
+			}
+
+			try
+			{
+				convert(*_node, _value);
+				_isValid = true;
+			}
+			catch (const std::runtime_error &e)
+			{
+				INI_DEBUG("handle convert failed: " << e.what());
+			}
+		}
+
+#ifdef _ENBABLE_INICPP_STD_WSTRING_
+		static void convert(const ValueNode &node, std::wstring &result)
+		{
+			result = WStringConverter::fromBytes(node.Value);
+		}
+#endif
+
+		static void convert(const ValueNode &node, bool &result)
+		{
+			std::string value = node.Value;
+			result = ValueProxy(value);
+		}
+
+		template <typename U>
+		static void convert(const ValueNode &node, U &result)
+		{
+			std::string value = node.Value;
+			ValueProxy proxy(value);
+			if (node.isArray)
+			{
+				proxy.setValues(&node.Values);
+			}
+			result = proxy.get<U>();
+		}
+
+	private:
+		const ini *_data = nullptr;
+		std::string _sectionName, _keyName;
+
+		mutable T _value;
+		mutable const ValueNode *_node = nullptr;
+		mutable std::size_t _generation = 0;
+		mutable bool _isValid = false;
+	};
+
+	template <typename Dialect = DefaultDialect>
+	class BasicIniManager : parentHelper
+	{
+	public:
+		explicit BasicIniManager(const std::string &configFileName = "") : _configFileName(configFileName)
+		{
+			_iniData.setParent(this);
+
+			parse();
+		}
+
+		section operator[](const std::string &sectionName)
+		{
+			return _iniData[sectionName];
+		}
+
+		// parse the config file, or the data of the last parse(data) again
+		void parse()
+		{
+			TraceSpan span("reload");
+
+			if (_isMemory)
+			{
+				parse(_memoryData.data(), _memoryData.length());
+				return;
+			}
+
+			if (_configFileName.empty())
+			{
+				return;
+			}
+
+			std::string data;
+			if (!IniParser::readFile(_configFileName, data, &_fileState))
+			{
+				INI_DEBUG("Failed to open the input INI file for parsing! file:" << _configFileName);
+				return;
+			}
+
+			_isCompressed = IniParser::compression(data.data(), data.length()) != IniParser::NONE;
+			if (!BasicIniParser<Dialect>::load(_iniData, data.data(), data.length(), _isInterpolation))
+			{
+				INI_DEBUG("Failed to decompress the input INI file! file:" << _configFileName);
+			}
+		}
+
+		// parse from memory, without config file: set() then modifies the data in memory
+		void parse(const char *data, std::size_t size)
+		{
+			if (!_isMemory || data != _memoryData.data())
+			{
+				_memoryData.assign(data, size);
+				_isMemory = true;
+			}
+
+			_isCompressed = IniParser::compression(_memoryData.data(), _memoryData.length()) != IniParser::NONE;
+			if (!BasicIniParser<Dialect>::load(_iniData, _memoryData.data(), _memoryData.length(), _isInterpolation))
+			{
+				INI_DEBUG("Failed to decompress the input INI data");
+			}
+		}
+
+#if __cplusplus >= 201703L
+		void parse(std::string_view data)
+		{
+			parse(data.data(), data.size());
+		}
+#else
+		void parse(const std::string &data)
+		{
+			parse(data.data(), data.length());
+		}
+#endif
+
+		// read in chunks straight into the memory data, parsed there without another copy
+		void parse(std::istream &input)
+		{
+			static const std::size_t CHUNK_SIZE = 64 * 1024;
+
+			std::size_t size = 0;
+			_memoryData.clear();
+			while (input)
+			{
+				_memoryData.resize(size + CHUNK_SIZE);
+				input.read(&_memoryData[size], CHUNK_SIZE);
+				size += static_cast<std::size_t>(input.gcount());
+			}
+			_memoryData.resize(size);
+			_isMemory = true;
+
+			parse(_memoryData.data(), _memoryData.length());
+		}
+
+		// key-values as ini text, in file order. comments and empty lines are not kept
+		std::string serialize() const
+		{
+			std::ostringstream output;
+			serialize(output);
+			return output.str();
+		}
+
+		void serialize(std::ostream &output) const
+		{
+			_iniData.serialize(output);
+		}
+
+		bool set(const std::string &Section, const std::string &Key, const std::string &Value, const std::string &comment = "") override
+		{
+			TraceSpan span("set");
+
+			if (!_batchDepth)
+			{
+				reload();
+			}
+
+			std::string key = Key, value = Value;
+
+			IniParser::trimEdges(key);
+			IniParser::trimEdges(key);
+
+			if (key == "" || value == "")
+			{
+				INI_DEBUG("Invalid parameter input: key[" << key << "],value[" << value << "]");
+				return false;
+			}
+
+			if (isContinuedValue(value))
+			{
+				INI_DEBUG("Value ending with '\\' would continue on the next line: key[" << key << "],value[" << value << "]");
+				return false;
+			}
+
+			return write(Section, key, key + "=" + value + "\n", comment);
+		}
+
+		// array: write as key[]=value for each, an empty array removes the key
+		template <typename T>
+		bool set(const std::string &Section, const std::string &Key, const std::vector<T> &Values, const std::string &comment = "")
+		{
+			TraceSpan span("set");
+
+			if (!_batchDepth)
+			{
+				reload();
+			}
+
+			std::string key = Key;
+			IniParser::trimEdges(key);
+
+			if (key == "")
+			{
+				INI_DEBUG("Invalid parameter input: key[" << key << "]");
+				return false;
+			}
+
+			std::string keyValueData;
+			for (const auto &value : Values)
+			{
+				const std::string text = ValueProxy::to_string(value);
+				if (isContinuedValue(text))
+				{
+					INI_DEBUG("Value ending with '\\' would continue on the next line: key[" << key << "],value[" << text << "]");
+					return false;
+				}
+				keyValueData += key + "[]=" + text + "\n";
+			}
+
+			if (keyValueData.empty() && !_batchDepth && !_iniData.getNode(Section, key))
+			{
+				return true;
+			}
+
+			return write(Section, key, keyValueData, keyValueData.empty() ? "" : comment);
+		}
+
+		bool set(const std::string &Section, const std::string &Key, const int Value, const std::string &comment = "")
+		{
+			std::string stringValue = std::to_string(Value);
+			return set(Section, Key, stringValue, comment);
+		}
+
+		bool set(const std::string &Section, const std::string &Key, const double &Value, const std::string &comment = "")
+		{
+			std::string stringValue = std::to_string(Value);
+			return set(Section, Key, stringValue, comment);
+		}
+
+		bool set(const std::string &Section, const std::string &Key, const char &Value, const std::string &comment = "")
+		{
+			std::string stringValue = ValueProxy::to_string(Value);
+			return set(Section, Key, stringValue, comment);
+		}
+
+		// no sections: head of config file
+		bool set(const std::string &Key, const std::string &Value)
+		{
+			return set("", Key, Value, "");
+		}
+		bool set(const std::string &Key, const char *Value)
+		{
+			return set("", Key, Value, "");
+		}
+		template <typename T>
+		bool set(const std::string &Key, const T &Value)
+		{
+			std::string stringValue = std::to_string(Value);
+			return set("", Key, stringValue, "");
+		}
+
+#ifdef _ENBABLE_INICPP_STD_WSTRING_
+		bool set(const std::string &Section, const std::string &Key, const std::wstring &Value, const std::string &comment = "")
+		{
+			std::string stringValue = WStringConverter::toBytes(Value);
+
+			return set(Section, Key, stringValue, comment);
+		}
+#endif
+		// comment for section name of key
+		bool setComment(const std::string &Section, const std::string &Key, const std::string &comment)
+		{
+			auto iter = _pendingIndex.find(std::make_pair(Section, Key));
+			if (iter != _pendingIndex.end()) // value written in this batch
+			{
+				_pending[iter->second].comment = comment;
+				return true;
+			}
+			const ValueNode *node = _iniData.getNode(Section, Key);
+			if (node && node->isArray) // as written in the file
+			{
+				return set(Section, Key, node->RawValues.empty() ? node->Values : node->RawValues, comment);
+			}
+			return set(Section, Key, (*this)[Section].getRaw(Key), comment);
+		}
+		// comment for no section name of key
+		bool setComment(const std::string &Key, const std::string &comment)
+		{
+			return setComment("", Key, comment);
+		}
+
+		bool isSectionExists(const std::string &sectionName) const
+		{
+			return _iniData.isSectionExists(sectionName);
+		}
+
+		// const lookup, never inserts: defaultValue if not found or conversion failed
+		template <typename T>
+		T get(const std::string &Section, const std::string &Key, const T &defaultValue) const
+		{
+			T result;
+			return _iniData.get(Section, Key, result) ? result : defaultValue;
+		}
+
+		std::string get(const std::string &Section, const std::string &Key, const char *defaultValue) const
+		{
+			return get<std::string>(Section, Key, defaultValue);
+		}
+
+#if __cplusplus >= 201703L
+		template <typename T>
+		std::optional<T> find(const std::string &Section, const std::string &Key) const
+		{
+			T result;
+			if (!_iniData.get(Section, Key, result))
+			{
+				return std::nullopt;
+			}
+			return result;
+		}
+#endif
+
+		inline std::list<std::string /*section name*/> sectionsList()
+		{
+			return _iniData.getSectionsList();
+		}
+
+		inline std::map<std::string /*key*/, std::string /*value*/> sectionMap(const std::string &sectionName)
+		{
+			return _iniData.getSectionMap(sectionName);
+		}
+
+		// all values of array, no copy: valid until the next parse() or set()
+		inline const std::vector<std::string> &getValues(const std::string &Section, const std::string &Key)
+		{
+			return _iniData.getValues(Section, Key);
+		}
+
+#ifdef _ENBABLE_INICPP_STD_WSTRING_
+		// converted once, until the value changes; throws std::range_error for invalid UTF-8
+		inline std::wstring toWString(const std::string &Section, const std::string &Key)
+		{
+			return _iniData.toWString(Section, Key);
+		}
+#endif
+
+		void setFileName(const std::string &fileName)
+		{
+			_configFileName = fileName;
+			_isMemory = false;
+			_memoryData.clear();
+		}
+
+		// resolve section-key once, then handle.get() only reconverts after a reload
+		template <typename T>
+		handle<T> bind(const std::string &sectionName, const std::string &Key)
+		{
+			return handle<T>(_iniData, sectionName, Key);
+		}
+
+		// ${section:key}, ${key} and ${ENV:NAME} in values, see ini::interpolate()
+		void setInterpolation(bool enable)
+		{
+			if (_isInterpolation != enable)
+			{
+				_isInterpolation = enable;
+				parse();
+			}
+		}
+
+		// increased by every reload of the config file
+		inline std::size_t generation() const { return _iniData.generation(); }
+
+		// copy of the current data, compare two of them with inicpp::diff()
+		inline ini snapshot() const { return _iniData; }
+
+		// check all values at once, see inicpp::schema
+		std::list<ValidationError> validate(const schema &rules) const
+		{
+			return rules.validate(_iniData);
+		}
+
+		/**
+		 * Deferred writes: set() and assignments through operator[] are recorded until
+		 * commit(), then written with one rewrite. The last write of a key wins. Reads
+		 * see the config before the batch. May be nested, the outermost commit() writes.
+		 */
+		void beginBatch()
+		{
+			++_batchDepth;
+		}
+
+		inline bool isBatching() override { return _batchDepth > 0; }
+
+		bool commit()
+		{
+			TraceSpan span("commit");
+
+			if (_batchDepth == 0 || --_batchDepth > 0)
+			{
+				return true;
+			}
+
+			std::vector<Pending> pending;
+			pending.swap(_pending);
+			_pendingIndex.clear();
+			if (pending.empty())
+			{
+				return true;
+			}
+
+			reload();
+
+			std::vector<Edit> edits;
+			std::vector<std::pair<std::string /*Section*/, std::string /*keyValueData*/>> newSections; // one insert for each
+			for (const auto &write : pending)
+			{
+				bool isExist = _iniData.getNode(write.section, write.key) != nullptr;
+				if (write.data.empty() && !isExist) // remove a key not exist
+				{
+					continue;
+				}
+
+				if (isExist || _iniData.isSectionExists(write.section))
+				{
+					planSet(write.section, write.key, write.data, write.comment, edits);
+					continue;
+				}
+
+				auto iter = std::find_if(newSections.begin(), newSections.end(), [&write](const std::pair<std::string, std::string> &sec)
+										 { return sec.first == write.section; });
+				if (iter == newSections.end()) // unnamed section is written to the head: before the others of an empty file
+				{
+					iter = newSections.insert(write.section.empty() ? newSections.begin() : newSections.end(), std::make_pair(write.section, std::string()));
+				}
+				iter->second += withComment(write.data, write.comment);
+			}
+
+			for (const auto &sec : newSections)
+			{
+				planSet(sec.first, "", sec.second, "", edits);
+			}
+
+			return edits.empty() || rewrite(edits);
+		}
+
+		// scoped beginBatch()/commit(): { auto batch = _ini.batch(); _ini["a"]["x"] = 1; _ini["a"]["y"] = 2; }
+		class Batch
+		{
+		public:
+			explicit Batch(BasicIniManager &manager) : _manager(&manager)
+			{
+				_manager->beginBatch();
+			}
+
+			Batch(Batch &&other) : _manager(other._manager)
+			{
+				other._manager = nullptr;
+			}
+
+			~Batch()
+			{
+				commit();
+			}
+
+			Batch(const Batch &) = delete;
+			Batch &operator=(const Batch &) = delete;
+
+			// write now, false if failed
+			bool commit()
+			{
+				BasicIniManager *manager = _manager;
+				_manager = nullptr;
+				return manager ? manager->commit() : true;
+			}
+
+		private:
+			BasicIniManager *_manager;
+		};
+
+		Batch batch()
+		{
+			return Batch(*this);
+		}
+
+	private:
+		// the file is rewritten as: [0, begin) + data + [end, ...)
+		typedef struct Edit
+		{
+			std::size_t begin, end;
+			std::string data;
+			std::string section, key; // key replaced, keys of data before any [section] are in section
+			bool isLocal;			  // false: data may belong to another section, parse all again
+		} Edit;
+
+		// a write recorded in batch
+		typedef struct Pending
+		{
+			std::string section, key, data, comment;
+		} Pending;
+
+		// write keyValueData of Section-key now, or record it in batch
+		bool write(const std::string &Section, const std::string &key, const std::string &keyValueData, const std::string &comment)
+		{
+			if (_batchDepth)
+			{
+				auto iter = _pendingIndex.find(std::make_pair(Section, key));
+				if (iter == _pendingIndex.end())
+				{
+					iter = _pendingIndex.emplace(std::make_pair(Section, key), _pending.size()).first;
+					_pending.push_back(Pending{Section, key, "", ""});
+				}
+				Pending &pending = _pending[iter->second];
+				pending.data = keyValueData;
+				if (!comment.empty() || keyValueData.empty()) // as one by one: an empty comment keeps the one written before
+				{
+					pending.comment = comment;
+				}
+				return true;
+			}
+
+			std::vector<Edit> edits;
+			planSet(Section, key, keyValueData, comment, edits);
+			return rewrite(edits);
+		}
+
+		// ;comment line before keyValueData
+		static std::string withComment(const std::string &keyValueData, const std::string &comment)
+		{
+			if (comment.empty())
+			{
+				return keyValueData;
+			}
+			return (comment[0] != ';' ? ";" : "") + comment + "\n" + keyValueData;
+		}
+
+		// edits to replace all lines of Section-key, or insert them, with keyValueData
+		void planSet(const std::string &Section, const std::string &key, std::string keyValueData, const std::string &comment, std::vector<Edit> &edits)
+		{
+			keyValueData = withComment(keyValueData, comment);
+
+			const std::size_t dataSize = _iniData.getDataSize();
+			std::size_t begin = dataSize, end = dataSize;
+
+			const ValueNode *node = _iniData.getNode(Section, key);
+
+			if (node && node->lineNumber > 0)
+			{ // found, replace it
+				std::vector<int> lines(1, node->lineNumber);
+				if (!node->valueLines.empty())
+				{
+					lines = node->valueLines;
+				}
+
+				begin = _iniData.getLineOffset(lines[0]);
+				end = _iniData.getLineOffset(_iniData.lastLine(lines[0]) + 1);
+
+				// delete old comment if new comment is set
+				if (comment != "" && _iniData.isCommentLine(lines[0] - 1))
+				{
+					begin = _iniData.getLineOffset(lines[0] - 1);
+				}
+
+				edits.push_back(Edit{begin, end, keyValueData, Section, key, true});
+
+				for (std::size_t i = 1; i < lines.size(); ++i) // other values of the array
+				{
+					edits.push_back(Edit{_iniData.getLineOffset(lines[i]), _iniData.getLineOffset(_iniData.lastLine(lines[i]) + 1), "", Section, key, true});
+				}
+				return;
+			}
+
+			bool isLocal = true;
+			if (_iniData.isSectionExists(Section))
+			{ // section exist, key not exist: append to next line of section end
+				int line_number_mark = _iniData.getEndSection(Section);
+				if (line_number_mark > 0)
+				{
+					begin = end = _iniData.getLineOffset(_iniData.lastLine(line_number_mark) + 1);
+				}
+				isLocal = line_number_mark > 0;
+			}
+			else
+			{ // not found key at config file
+				bool isHoldSection = false;
+				std::string newLine = "\n\n";
+				if (Section != "" && Section.find("[") == std::string::npos && Section.find("]") == std::string::npos && Section.find("=") == std::string::npos)
+				{
+					if (_iniData.empty() || _iniData.getSectionSize() <= 0)
+					{
+						newLine.clear();
+					}
+
+					isHoldSection = true;
+				}
+
+				if (isHoldSection)
+				{
+					keyValueData = newLine + "[" + Section + "]" + "\n" + keyValueData;
+				}
+				isLocal = isHoldSection || Section == ""; // else: in the last section of file
+
+				// 1.empty section: write key/value to head, 2.section is not exist: write key/value to end
+				if (Section == "")
+				{
+					begin = end = 0;
+				}
+			}
+
+			edits.push_back(Edit{begin, end, keyValueData, Section, key, isLocal});
+		}
+
+		// apply edits to the config file through a temp file, then reload
+		bool rewrite(std::vector<Edit> &edits)
+		{
+			TraceSpan span("rewrite");
+
+			if (_isCompressed)
+			{
+				INI_DEBUG("Compressed config is read-only: " << _configFileName);
+				return false;
+			}
+
+			std::stable_sort(edits.begin(), edits.end(), [](const Edit &a, const Edit &b)
+							 { return a.begin < b.begin; });
+
+			if (_isMemory)
+			{
+				std::string output;
+				std::size_t position = 0;
+				for (const auto &edit : edits)
+				{
+					appendLines(output, position, edit.begin);
+					output += edit.data;
+					position = std::max(position, edit.end);
+				}
+				appendLines(output, position, _memoryData.length());
+
+				_memoryData.swap(output);
+				if (!applyEdits(edits))
+				{
+					parse();
+				}
+				return true;
+			}
+
+			const std::string tempFile = _configFileName + ".temp"; // same directory: rename() does not cross file systems
+#ifdef INICPP_POSIX_IO
+			int input = ::open(_configFileName.c_str(), O_RDONLY);
+			int output = ::open(tempFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+			if (input < 0 && _iniData.getDataSize() > 0) // not exist: nothing to copy
+			{
+				INI_DEBUG("Failed to open the input INI file for modification! File name:" << _configFileName);
+				closeFile(output);
+				return false;
+			}
+
+			if (output < 0)
+			{
+				INI_DEBUG("Failed to open the output INI file for modification!");
+				closeFile(input);
+				return false;
+			}
+#else
+			std::fstream input(_configFileName, std::ifstream::in | std::ifstream::binary);
+			std::ofstream output(tempFile, std::ofstream::out | std::ofstream::binary);
+
+			if (!input.is_open() && _iniData.getDataSize() > 0) // not exist: nothing to copy
+			{
+				INI_DEBUG("Failed to open the input INI file for modification! File name:" << _configFileName);
+				return false;
+			}
+
+			if (!output.is_open())
+			{
+				INI_DEBUG("Failed to open the output INI file for modification!");
+				return false;
+			}
+#endif
+
+			bool isCopied = true;
+			std::size_t position = 0;
+
+			for (const auto &edit : edits)
+			{
+				isCopied = isCopied && copyLines(input, output, position, edit.begin) &&
+						   writeData(output, edit.data.data(), edit.data.length());
+				position = std::max(position, edit.end);
+			}
+			isCopied = isCopied && copyLines(input, output, position, _iniData.getDataSize());
+
+			// clear work
+			closeFile(input);
+			isCopied = closeFile(output) && isCopied;
+
+			if (!isCopied)
+			{
+				INI_DEBUG("Failed to write the output INI file for modification!");
+				std::remove(tempFile.c_str());
+				return false;
+			}
+
+			if (!replaceFile(tempFile, _configFileName))
+			{
+				INI_DEBUG("Failed to replace the INI file by the output file! file:" << _configFileName);
+				return false; // file and data stay as before
+			}
+
+			// reload
+			if (!applyEdits(edits))
+			{
+				parse();
+				return true;
+			}
+
+#ifdef INICPP_POSIX_IO
+			struct stat info;
+			_fileState.isValid = ::stat(_configFileName.c_str(), &info) == 0;
+			if (_fileState.isValid)
+			{
+				_fileState = IniParser::fileState(info);
+			}
+#endif
+			return true;
+		}
+
+		// with Dialect::lineContinuation the written line would take the next one in, there is no escape for it
+		static bool isContinuedValue(const std::string &value)
+		{
+			std::size_t last = value.find_last_not_of(" \t\r");
+			return Dialect::lineContinuation && last != std::string::npos && value[last] == '\\';
+		}
+
+		// the old file stays until it is replaced, at once on POSIX; tempFile is removed if fileName is unchanged
+		static bool replaceFile(const std::string &tempFile, const std::string &fileName)
+		{
+			if (std::rename(tempFile.c_str(), fileName.c_str()) == 0)
+			{
+				return true;
+			}
+#ifdef _WIN32 // rename() does not replace an existing file
+			if (std::remove(fileName.c_str()) == 0)
+			{
+				return std::rename(tempFile.c_str(), fileName.c_str()) == 0; // else the written data stays in tempFile
+			}
+#endif
+			std::remove(tempFile.c_str());
+			return false;
+		}
+
+		// parse again before a write, only if the file changed since the last parse
+		void reload()
+		{
+			if (_isMemory)
+			{
+				return; // changed only by parse(data) and set()
+			}
+#ifdef INICPP_POSIX_IO
+			struct stat info;
+			if (::stat(_configFileName.c_str(), &info) == 0 && IniParser::fileState(info) == _fileState)
+			{
+				return;
+			}
+#endif
+			parse();
+		}
+
+		/**
+		 * Update _iniData for the written edits, without parsing the whole file again:
+		 * the line index and line numbers are shifted, the edited keys are replaced by
+		 * their new lines parsed alone. false if a full parse is needed.
+		 */
+		bool applyEdits(const std::vector<Edit> &edits)
+		{
+			const std::vector<std::size_t> &oldOffsets = _iniData.lineOffsets();
+			if (_isInterpolation || _iniData.hasContinuedLines() || oldOffsets.empty())
+			{
+				return false; // values or lines depend on other lines
+			}
+			for (const auto &edit : edits)
+			{
+				if (!edit.isLocal)
+				{
+					return false;
+				}
+			}
+
+			const std::size_t dataSize = _iniData.getDataSize();
+			const bool isEndNewLine = oldOffsets.back() == dataSize;
+
+			std::vector<int> lineMap(oldOffsets.size() + 1, -1);
+			std::vector<std::size_t> offsets;
+			std::vector<bool> comments;
+			offsets.reserve(oldOffsets.size() + edits.size() * 2);
+			comments.reserve(oldOffsets.size() + edits.size() * 2);
+
+			std::size_t output = 0, line = 0;
+			auto copy = [&](std::size_t begin, std::size_t end)
+			{
+				if (begin >= end)
+				{
+					return;
+				}
+				while (line < oldOffsets.size() && oldOffsets[line] < begin) // removed lines
+				{
+					++line;
+				}
+				for (; line < oldOffsets.size() && oldOffsets[line] < end; ++line)
+				{
+					offsets.push_back(oldOffsets[line] - begin + output);
+					comments.push_back(_iniData.isCommentLine(static_cast<int>(line) + 1));
+					lineMap[line + 1] = static_cast<int>(offsets.size());
+				}
+				output += end - begin;
+				if (end == dataSize && !isEndNewLine) // copyLines() added '\n'
+				{
+					++output;
+				}
+			};
+
+			std::vector<int> firstLines;
+			std::size_t position = 0;
+			for (const auto &edit : edits)
+			{
+				copy(position, edit.begin);
+				position = std::max(position, edit.end);
+
+				firstLines.push_back(static_cast<int>(offsets.size()) + 1);
+				for (std::size_t begin = 0; begin < edit.data.length();)
+				{
+					offsets.push_back(output + begin);
+					comments.push_back(edit.data[begin] == ';');
+					std::size_t end = edit.data.find('\n', begin);
+					begin = end == std::string::npos ? edit.data.length() : end + 1;
+				}
+				output += edit.data.length();
+			}
+			copy(position, dataSize);
+			offsets.push_back(output); // after the last '\n'
+			comments.push_back(false);
+
+			_iniData.setLineIndex(offsets, comments, output);
+
+			std::size_t generation = _iniData.nextGeneration();
+			for (const auto &edit : edits)
+			{
+				_iniData.eraseKey(edit.section, edit.key, generation);
+			}
+			_iniData.remapLines(lineMap);
+
+			for (std::size_t i = 0; i < edits.size(); ++i)
+			{
+				if (edits[i].data.empty())
+				{
+					continue;
+				}
+				ini text;
+				BasicIniParser<Dialect> parser(text);
+				parser.feed(edits[i].data.data(), edits[i].data.length());
+				parser.finish();
+				_iniData.merge(text, firstLines[i], edits[i].section, generation);
+			}
+			return true;
+		}
+
+		// memory version of copyLines()
+		void appendLines(std::string &output, std::size_t begin, std::size_t end)
+		{
+			if (begin >= end)
+			{
+				return;
+			}
+			output.append(_memoryData, begin, end - begin);
+			if (_memoryData[end - 1] != '\n')
+			{
+				output += "\n";
+			}
+		}
+
+#ifdef INICPP_POSIX_IO
+		bool writeData(int output, const char *data, std::size_t length)
+		{
+			while (length > 0)
+			{
+				ssize_t written = ::write(output, data, length);
+				if (written < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				if (written <= 0)
+				{
+					return false;
+				}
+				data += written;
+				length -= static_cast<std::size_t>(written);
+			}
+			return true;
+		}
+
+		char readByte(int input, std::size_t offset)
+		{
+			char byte = '\0';
+			if (::pread(input, &byte, 1, static_cast<off_t>(offset)) != 1)
+			{
+				return '\0';
+			}
+			return byte;
+		}
+
+		bool closeFile(int fd)
+		{
+			return fd < 0 || ::close(fd) == 0;
+		}
+
+		// bulk copy of [begin, end) from input, the copied lines always end with '\n'.
+		// copy_file_range/sendfile keep the data in the kernel, read/write is the fallback.
+		bool copyLines(int input, int output, std::size_t begin, std::size_t end)
+		{
+			if (begin >= end)
+			{
+				return true;
+			}
+
+			off_t offset = static_cast<off_t>(begin);
+			std::size_t remain = end - begin;
+
+#ifdef INICPP_HAS_COPY_FILE_RANGE
+			while (remain > 0)
+			{
+				ssize_t copied = ::copy_file_range(input, &offset, output, nullptr, remain, 0);
+				if (copied <= 0)
+				{
+					break; // EXDEV, ENOSYS...: try next way
+				}
+				remain -= static_cast<std::size_t>(copied);
+			}
+#endif
+
+#if defined(__linux__)
+			while (remain > 0)
+			{
+				ssize_t copied = ::sendfile(output, input, &offset, remain);
+				if (copied <= 0)
+				{
+					break;
+				}
+				remain -= static_cast<std::size_t>(copied);
+			}
+#endif
+
+			if (remain > 0)
+			{
+				std::vector<char> buffer(std::min<std::size_t>(remain, 1024 * 1024));
+				while (remain > 0)
+				{
+					ssize_t got = ::pread(input, buffer.data(), std::min(remain, buffer.size()), offset);
+					if (got < 0 && errno == EINTR)
+					{
+						continue;
+					}
+					if (got <= 0 || !writeData(output, buffer.data(), static_cast<std::size_t>(got)))
+					{
+						return false;
+					}
+					offset += got;
+					remain -= static_cast<std::size_t>(got);
+				}
+			}
+
+			if (readByte(input, end - 1) != '\n')
+			{
+				return writeData(output, "\n", 1);
+			}
+
+			return true;
+		}
+#else
+		bool writeData(std::ostream &output, const char *data, std::size_t length)
+		{
+			output.write(data, static_cast<std::streamsize>(length));
+			return output.good();
+		}
+
+		template <typename Stream>
+		bool closeFile(Stream &file)
+		{
+			file.close();
+			return !file.fail();
+		}
+
+		// bulk copy of [begin, end) from input, the copied lines always end with '\n'
+		bool copyLines(std::istream &input, std::ostream &output, std::size_t begin, std::size_t end)
+		{
+			if (begin >= end)
+			{
+				return true;
+			}
+
+			input.clear();
+			input.seekg(begin, input.beg);
+
+			std::vector<char> buffer(std::min<std::size_t>(end - begin, 1024 * 1024));
+			std::size_t remain = end - begin;
+			char last = '\n';
+
+			while (remain > 0)
+			{
+				std::streamsize wanted = static_cast<std::streamsize>(std::min(remain, buffer.size()));
+				input.read(buffer.data(), wanted);
+				std::streamsize got = input.gcount();
+				if (got <= 0)
+				{
+					return false;
+				}
+
+				output.write(buffer.data(), got);
+				last = buffer[got - 1];
+				remain -= static_cast<std::size_t>(got);
+			}
+
+			if (last != '\n')
+			{
+				output << "\n";
+			}
+
+			return output.good();
+		}
+#endif
+
+	private:
+		ini _iniData;
+		bool _isInterpolation = false;
+		std::string _configFileName;
+
+		bool _isMemory = false; // parsed from memory
+		std::string _memoryData;
+		bool _isCompressed = false; // gzip/zstd: read-only
+		FileState _fileState;		// of the last parse or write
+
+		int _batchDepth = 0; // see beginBatch()
+		std::vector<Pending> _pending;
+		std::map<std::pair<std::string, std::string>, std::size_t /*index of _pending*/> _pendingIndex;
+	};
+
+	typedef BasicIniManager<> IniManager;
+
+	/**
+	 * Read-only config for read-only or shared files: parse() opens the file read-only,
+	 * reads it with one call and closes it at once. There is no set(), and operator[]
+	 * gives a const view, so an assignment through it does not compile.
+	 */
+	template <typename Dialect = DefaultDialect>
+	class BasicIniReader
+	{
+	public:
+		explicit BasicIniReader(const std::string &configFileName = "") : _configFileName(configFileName)
+		{
+			parse();
+		}
+
+		// read-only view: reader["server"]["port"] = 5 does not compile
+		const section operator[](const std::string &sectionName)
+		{
+			return _iniData[sectionName];
+		}
+
+		// reload
+		void parse()
+		{
+			TraceSpan span("reload");
+
+			if (_configFileName.empty())
+			{
+				return;
+			}
+
+			std::string data;
+			if (!IniParser::readFile(_configFileName, data))
+			{
+				INI_DEBUG("Failed to open the input INI file for parsing! file:" << _configFileName);
+				return;
+			}
+
+			if (!BasicIniParser<Dialect>::load(_iniData, data.data(), data.length(), _isInterpolation))
+			{
+				INI_DEBUG("Failed to decompress the input INI file! file:" << _configFileName);
+			}
+		}
+
+		void setFileName(const std::string &fileName)
+		{
+			_configFileName = fileName;
+		}
+
+		// see IniManager::setInterpolation()
+		void setInterpolation(bool enable)
+		{
+			if (_isInterpolation != enable)
+			{
+				_isInterpolation = enable;
+				parse();
+			}
+		}
+
+		bool isSectionExists(const std::string &sectionName) const
+		{
+			return _iniData.isSectionExists(sectionName);
+		}
+
+		// const lookup, never inserts: defaultValue if not found or conversion failed
+		template <typename T>
+		T get(const std::string &Section, const std::string &Key, const T &defaultValue) const
+		{
+			T result;
+			return _iniData.get(Section, Key, result) ? result : defaultValue;
+		}
+
+		std::string get(const std::string &Section, const std::string &Key, const char *defaultValue) const
+		{
+			return get<std::string>(Section, Key, defaultValue);
+		}
+
+#if __cplusplus >= 201703L
+		template <typename T>
+		std::optional<T> find(const std::string &Section, const std::string &Key) const
+		{
+			T result;
+			if (!_iniData.get(Section, Key, result))
+			{
+				return std::nullopt;
+			}
+			return result;
+		}
+#endif
+
+		inline std::list<std::string /*section name*/> sectionsList()
+		{
+			return _iniData.getSectionsList();
+		}
+
+		inline std::map<std::string /*key*/, std::string /*value*/> sectionMap(const std::string &sectionName)
+		{
+			return _iniData.getSectionMap(sectionName);
+		}
+
+		template <typename T>
+		handle<T> bind(const std::string &sectionName, const std::string &Key)
+		{
+			return handle<T>(_iniData, sectionName, Key);
+		}
+
+		inline std::size_t generation() const { return _iniData.generation(); }
+
+		inline ini snapshot() const { return _iniData; }
+
+		std::list<ValidationError> validate(const schema &rules) const
+		{
+			return rules.validate(_iniData);
+		}
 
-						std::string lineData;
-						int input_line_number = 0;
-						while (std::getline(input, lineData))
-						{
-							++input_line_number;
+		std::string serialize() const
+		{
+			std::ostringstream output;
+			_iniData.serialize(output);
+			return output.str();
+		}
 
-							if (input_line_number == (line_number_mark + 1))
-							{ // new line,append to next line
-								isInputDataWited = true;
-								output << keyValueData;
-							}
+	private:
+		ini _iniData;
+		bool _isInterpolation = false;
+		std::string _configFileName;
+	};
 
-							output << lineData << "\n";
-						}
+	typedef BasicIniReader<> IniReader;
+
+	/**
+	 * Load the config off the calling thread, for event loops. Config is IniReader by
+	 * default, or any config class constructed from a file name. The result is ready to use.
+	 * Executor is any callable taking a std::function<void()>, e.g. posting to a thread pool:
+	 *   auto future = inicpp::loadAsync("config.ini", [&pool](std::function<void()> task) { pool.post(task); });
+	 *   std::shared_ptr<inicpp::IniReader> config = future.get();
+	 */
+	template <typename Config = IniReader, typename Executor>
+	std::future<std::shared_ptr<Config>> loadAsync(const std::string &fileName, Executor &&executor)
+	{
+		auto task = std::make_shared<std::packaged_task<std::shared_ptr<Config>()>>([fileName]()
+																				   { return std::make_shared<Config>(fileName); });
+		std::future<std::shared_ptr<Config>> result = task->get_future();
+		executor(std::function<void()>([task]()
+									   { (*task)(); }));
+		return result;
+	}
 
-						if (input.eof() && !isInputDataWited)
-						{
-							isInputDataWited = true;
-							output << keyValueData;
-						}
+	// on a new thread
+	template <typename Config = IniReader>
+	std::future<std::shared_ptr<Config>> loadAsync(const std::string &fileName)
+	{
+		return std::async(std::launch::async, [fileName]()
+						  { return std::make_shared<Config>(fileName); });
+	}
 
-						break;
-					}
-				}
+	// done(std::shared_ptr<Config>) is called on the executor, post it back to your loop if needed
+	template <typename Config = IniReader, typename Executor, typename Callback>
+	void loadAsync(const std::string &fileName, Executor &&executor, Callback done)
+	{
+		executor(std::function<void()>([fileName, done]()
+									   { done(std::make_shared<Config>(fileName)); }));
+	}
 
-				if (line_number_mark <= 0) // not found key at config file
-				{
-					input.seekg(0, input.beg);
+#ifdef INICPP_HAS_COROUTINE
+	/**
+	 * C++20: std::shared_ptr<inicpp::IniReader> config = co_await inicpp::awaitLoad("config.ini", executor);
+	 * The coroutine is resumed on the executor, or goes on at once if the executor runs the task inline;
+	 * exceptions of loading are thrown by co_await.
+	 */
+	template <typename Config, typename Executor>
+	class LoadAwaitable
+	{
+	public:
+		LoadAwaitable(const std::string &fileName, Executor executor) : _fileName(fileName), _executor(std::move(executor)) {}
 
-					bool isHoldSection = false;
-					std::string newLine = "\n\n";
-					if (Section != "" && Section.find("[") == std::string::npos && Section.find("]") == std::string::npos && Section.find("=") == std::string::npos)
-					{
-						if (_iniData.empty() || _iniData.getSectionSize() <= 0)
-						{
-							newLine.clear();
-						}
+		bool await_ready() const noexcept { return false; }
 
-						isHoldSection = true;
-					}
+		// false: loaded before the coroutine was suspended, it goes on without resume()
+		bool await_suspend(std::coroutine_handle<> coroutine)
+		{
+			_executor(std::function<void()>([this, coroutine]()
+											{
+												try
+												{
+													_config = std::make_shared<Config>(_fileName);
+												}
+												catch (...)
+												{
+													_error = std::current_exception();
+												}
+												// the second of task and await_suspend() resumes; this may be gone after the exchange
+												if (_isDone.exchange(true, std::memory_order_acq_rel))
+												{
+													coroutine.resume();
+												} }));
+			return !_isDone.exchange(true, std::memory_order_acq_rel);
+		}
 
-					// 1.section is exist or empty section
-					if (_iniData.isSectionExists(Section) || Section == "")
-					{
-						// write key/value to head
-						if (isHoldSection)
-						{
-							output << newLine << "[" << Section << "]" << "\n";
-						}
-						output << keyValueData;
-						// write others
-						std::string lineData;
-						while (std::getline(input, lineData))
-						{
-							output << lineData << "\n";
-						}
-					}
-					// 2.section is not exist
-					else
-					{
-						// write others
-						std::string lineData;
-						while (std::getline(input, lineData))
-						{
-							output << lineData << "\n";
-						}
-						// write key/value to end
-						if (isHoldSection)
-						{
-							output << newLine << "[" << Section << "]" << "\n";
-						}
-						output << keyValueData;
-					}
+		std::shared_ptr<Config> await_resume()
+		{
+			if (_error)
+			{
+				std::rethrow_exception(_error);
+			}
+			return std::move(_config);
+		}
 
-					break;
+	private:
+		std::string _fileName;
+		Executor _executor;
+		std::shared_ptr<Config> _config;
+		std::exception_ptr _error;
+		std::atomic<bool> _isDone{false}; // set by the first of task and await_suspend()
+	};
+
+	template <typename Config = IniReader, typename Executor>
+	LoadAwaitable<Config, typename std::decay<Executor>::type> awaitLoad(const std::string &fileName, Executor &&executor)
+	{
+		return LoadAwaitable<Config, typename std::decay<Executor>::type>(fileName, std::forward<Executor>(executor));
+	}
+#endif
+
+#ifdef INICPP_POSIX_IO
+	/**
+	 * Layout of config in POSIX shared memory, all positions are offsets from the
+	 * segment start, so every process can map it at any address:
+	 *   ShmHeader | ShmSection[sectionCount] | ShmKey[] of each section | names and values
+	 * Sections and keys are sorted by name for binary search in place.
+	 * sequence is a seqlock: odd while the publisher is writing.
+	 */
+	class IniShm
+	{
+	protected:
+		static const std::uint32_t MAGIC = 0x494e4931; // "INI1"
+		static const int MAX_RETRIES = 4096;		   // reads of a subscriber, then it gives up: publisher died while writing
+
+		typedef struct ShmHeader
+		{
+			std::uint32_t magic;
+			std::uint32_t sectionCount;
+			std::atomic<std::uint32_t> sequence;
+			std::uint32_t reserved;
+			std::uint64_t capacity; // size of segment
+			std::uint64_t generation;
+		} ShmHeader;
+
+		typedef struct ShmSection
+		{
+			std::uint64_t name;
+			std::uint32_t nameLength;
+			std::uint32_t keyCount;
+			std::uint64_t keyTable;
+		} ShmSection;
+
+		typedef struct ShmKey
+		{
+			std::uint64_t key;
+			std::uint32_t keyLength;
+			std::uint32_t valueLength;
+			std::uint64_t value;
+		} ShmKey;
+
+		static std::size_t align(std::size_t size)
+		{
+			return (size + 7) & ~static_cast<std::size_t>(7);
+		}
+
+		// shm_open() names start with '/'
+		static std::string shmName(const std::string &name)
+		{
+			return name.empty() || name[0] == '/' ? name : "/" + name;
+		}
+	};
+
+	/**
+	 * Publish parsed config to POSIX shared memory for IniSubscriber in other processes
+	 * (link with -lrt before glibc 2.34). One publisher per segment:
+	 *   inicpp::IniPublisher publisher("app-config");
+	 *   publisher.publish(_ini.snapshot()); // again after every reload
+	 * Published values are the plain values: interpolated, the last one of an array.
+	 */
+	class IniPublisher : protected IniShm
+	{
+	public:
+		explicit IniPublisher(const std::string &name, std::size_t capacity = 4 * 1024 * 1024) : _name(shmName(name))
+		{
+			int fd = ::shm_open(_name.c_str(), O_CREAT | O_RDWR, 0644);
+			if (fd < 0)
+			{
+				INI_DEBUG("Failed to open shared memory: " << _name);
+				return;
+			}
+
+			struct stat info;
+			if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) > capacity)
+			{
+				capacity = static_cast<std::size_t>(info.st_size); // keep size for mapped subscribers
+			}
+
+			if (::ftruncate(fd, static_cast<off_t>(capacity)) == 0)
+			{
+				void *address = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				if (address != MAP_FAILED)
+				{
+					_header = static_cast<ShmHeader *>(address);
+					_capacity = capacity;
 				}
-				else
-				{ // found, replace it
+			}
+			::close(fd);
 
-					std::string lineData;
-					int input_line_number = 0;
+			if (!_header)
+			{
+				INI_DEBUG("Failed to map shared memory: " << _name);
+				return;
+			}
 
-					while (std::getline(input, lineData))
-					{
-						++input_line_number;
+			if (_header->magic != MAGIC) // new segment
+			{
+				new (&_header->sequence) std::atomic<std::uint32_t>(0);
+				_header->sectionCount = 0;
+				_header->capacity = _capacity;
+				_header->generation = 0;
+				_header->magic = MAGIC;
+			}
+			else if (_header->sequence.load(std::memory_order_acquire) & 1) // last publisher died while writing: drop its torn data
+			{
+				INI_DEBUG("Reset stale shared memory: " << _name);
+				_header->sectionCount = 0;
+				_header->generation = 0;
+				_header->sequence.fetch_add(1, std::memory_order_release);
+			}
+		}
 
-						// delete old comment if new comment is set
-						if (input_line_number == (line_number_mark - 1) && lineData.length() > 0 && lineData[0] == ';' && comment != "")
-						{
-							continue;
-						}
+		~IniPublisher()
+		{
+			if (_header)
+			{
+				::munmap(_header, _capacity);
+			}
+		}
 
-						if (input_line_number == line_number_mark)
-						{ // replace to this line
-							output << keyValueData;
-						}
-						else
-						{
-							output << lineData << "\n";
-						}
-					}
-					break;
+		IniPublisher(const IniPublisher &) = delete;
+		IniPublisher &operator=(const IniPublisher &) = delete;
+
+		bool isOpen() const { return _header != nullptr; }
+
+		// false if not open or the data does not fit into the segment
+		bool publish(const ini &data)
+		{
+			if (!_header)
+			{
+				return false;
+			}
+
+			std::size_t keyCount = 0, textSize = 0;
+			for (const auto &sec : data._iniInfoMap)
+			{
+				textSize += sec.first.length();
+				for (const auto &key : sec.second._sectionMap)
+				{
+					++keyCount;
+					textSize += key.first.length() + key.second.Value.length();
 				}
+			}
+
+			const std::size_t sectionTable = align(sizeof(ShmHeader));
+			const std::size_t keyTable = sectionTable + data._iniInfoMap.size() * sizeof(ShmSection);
+			const std::size_t textBegin = keyTable + keyCount * sizeof(ShmKey);
+			const std::size_t totalSize = textBegin + textSize;
 
-				INI_DEBUG("error! inicpp lost process of set function");
+			if (totalSize > _capacity)
+			{
+				INI_DEBUG("Shared memory is too small: " << totalSize << " > " << _capacity);
 				return false;
+			}
 
-			} while (false);
+			// build out of the segment, keep the write window short
+			std::vector<char> buffer(totalSize - sectionTable);
+			char *base = buffer.data() - sectionTable; // offsets are from the segment start
+			std::size_t sectionIndex = 0, keyIndex = 0, text = textBegin;
 
-			// clear work
-			input.close();
-			output.close();
+			auto addText = [&](const std::string &value) -> std::uint64_t
+			{
+				std::memcpy(base + text, value.data(), value.length());
+				text += value.length();
+				return text - value.length();
+			};
 
-			std::remove(_configFileName.c_str());
-			std::rename(tempFile.c_str(), _configFileName.c_str());
+			for (const auto &sec : data._iniInfoMap)
+			{
+				ShmSection entry;
+				entry.nameLength = static_cast<std::uint32_t>(sec.first.length());
+				entry.name = addText(sec.first);
+				entry.keyCount = static_cast<std::uint32_t>(sec.second._sectionMap.size());
+				entry.keyTable = keyTable + keyIndex * sizeof(ShmKey);
 
-			// reload
-			parse();
+				for (const auto &key : sec.second._sectionMap)
+				{
+					ShmKey keyEntry;
+					keyEntry.keyLength = static_cast<std::uint32_t>(key.first.length());
+					keyEntry.key = addText(key.first);
+					keyEntry.valueLength = static_cast<std::uint32_t>(key.second.Value.length());
+					keyEntry.value = addText(key.second.Value);
+					std::memcpy(base + keyTable + (keyIndex++) * sizeof(ShmKey), &keyEntry, sizeof(keyEntry));
+				}
+
+				std::memcpy(base + sectionTable + (sectionIndex++) * sizeof(ShmSection), &entry, sizeof(entry));
+			}
+
+			std::uint32_t sequence = _header->sequence.load(std::memory_order_relaxed);
+			_header->sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
 
+			std::memcpy(reinterpret_cast<char *>(_header) + sectionTable, buffer.data(), buffer.size());
+			_header->sectionCount = static_cast<std::uint32_t>(data._iniInfoMap.size());
+			_header->generation = data.generation();
+
+			_header->sequence.store(sequence + 2, std::memory_order_release);
 			return true;
 		}
 
-		bool set(const std::string &Section, const std::string &Key, const int Value, const std::string &comment = "")
+		// remove the segment name, mapped subscribers keep their mapping
+		static bool remove(const std::string &name)
 		{
-			std::string stringValue = std::to_string(Value);
-			return set(Section, Key, stringValue, comment);
+			return ::shm_unlink(shmName(name).c_str()) == 0;
 		}
 
-		bool set(const std::string &Section, const std::string &Key, const double &Value, const std::string &comment = "")
-		{
-			std::string stringValue = std::to_string(Value);
-			return set(Section, Key, stringValue, comment);
-		}
+	private:
+		std::string _name;
+		ShmHeader *_header = nullptr;
+		std::size_t _capacity = 0;
+	};
 
-		bool set(const std::string &Section, const std::string &Key, const char &Value, const std::string &comment = "")
+	/**
+	 * Read-only view of config published by IniPublisher. Lookups run in place in the
+	 * shared memory, and see a new publish at once:
+	 *   inicpp::IniSubscriber config("app-config");
+	 *   std::string port;
+	 *   if (config.get("server", "port", port)) { ... }
+	 */
+	class IniSubscriber : protected IniShm
+	{
+	public:
+		explicit IniSubscriber(const std::string &name)
 		{
-			std::string stringValue = ValueProxy::to_string(Value);
-			return set(Section, Key, stringValue, comment);
+			int fd = ::shm_open(shmName(name).c_str(), O_RDONLY, 0);
+			if (fd < 0)
+			{
+				INI_DEBUG("Failed to open shared memory: " << name);
+				return;
+			}
+
+			struct stat info;
+			if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(ShmHeader))
+			{
+				void *address = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+				if (address != MAP_FAILED)
+				{
+					_base = static_cast<const char *>(address);
+					_capacity = static_cast<std::size_t>(info.st_size);
+				}
+			}
+			::close(fd);
+
+			if (_base && header()->magic != MAGIC)
+			{
+				INI_DEBUG("Not a published config: " << name);
+				::munmap(const_cast<char *>(_base), _capacity);
+				_base = nullptr;
+			}
 		}
 
-		// no sections: head of config file
-		bool set(const std::string &Key, const std::string &Value)
+		~IniSubscriber()
 		{
-			return set("", Key, Value, "");
+			if (_base)
+			{
+				::munmap(const_cast<char *>(_base), _capacity);
+			}
 		}
-		bool set(const std::string &Key, const char *Value)
+
+		IniSubscriber(const IniSubscriber &) = delete;
+		IniSubscriber &operator=(const IniSubscriber &) = delete;
+
+		bool isOpen() const { return _base != nullptr; }
+
+		// false if not found, or no consistent read within MAX_RETRIES
+		bool get(const std::string &Section, const std::string &Key, std::string &value) const
 		{
-			return set("", Key, Value, "");
+			if (!_base)
+			{
+				return false;
+			}
+
+			for (int retry = 0; retry < MAX_RETRIES; ++retry)
+			{
+				std::uint32_t sequence = header()->sequence.load(std::memory_order_acquire);
+				if (sequence & 1)
+				{
+					::sched_yield(); // publishing
+					continue;
+				}
+
+				bool isFound = find(Section, Key, value);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (header()->sequence.load(std::memory_order_relaxed) == sequence)
+				{
+					return isFound;
+				}
+			}
+
+			INI_DEBUG("Shared memory stays in publishing, give up: " << Section << "-" << Key);
+			return false;
 		}
+
+		// converted value, or defaultValue if not found or conversion failed
 		template <typename T>
-		bool set(const std::string &Key, const T &Value)
+		T get(const std::string &Section, const std::string &Key, const T &defaultValue) const
 		{
-			std::string stringValue = std::to_string(Value);
-			return set("", Key, stringValue, "");
+			std::string value;
+			if (!get(Section, Key, value))
+			{
+				return defaultValue;
+			}
+
+			try
+			{
+				return ValueProxy(value).get<T>();
+			}
+			catch (const std::runtime_error &e)
+			{
+				INI_DEBUG("IniSubscriber convert failed: " << e.what());
+				return defaultValue;
+			}
 		}
 
-#ifdef _ENBABLE_INICPP_STD_WSTRING_
-		bool set(const std::string &Section, const std::string &Key, const std::wstring &Value, const std::string &comment = "")
+		// generation of the published ini, changes with every publish of a reload; 0 if not readable
+		std::size_t generation() const
 		{
-			std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-			std::string stringValue = converter.to_bytes(Value);
+			if (!_base)
+			{
+				return 0;
+			}
 
-			return set(Section, Key, stringValue, comment);
-		}
-#endif
-		// comment for section name of key
-		bool setComment(const std::string &Section, const std::string &Key, const std::string &comment)
-		{
-			return set(Section, Key, (*this)[Section].toString(Key), comment);
-		}
-		// comment for no section name of key
-		bool setComment(const std::string &Key, const std::string &comment)
-		{
-			return set("", Key, (*this)[""].toString(Key), comment);
-		}
+			for (int retry = 0; retry < MAX_RETRIES; ++retry)
+			{
+				std::uint32_t sequence = header()->sequence.load(std::memory_order_acquire);
+				if (sequence & 1)
+				{
+					::sched_yield(); // publishing
+					continue;
+				}
 
-		bool isSectionExists(const std::string &sectionName)
-		{
-			return _iniData.isSectionExists(sectionName);
+				std::uint64_t generation = header()->generation;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (header()->sequence.load(std::memory_order_relaxed) == sequence)
+				{
+					return static_cast<std::size_t>(generation);
+				}
+			}
+
+			INI_DEBUG("Shared memory stays in publishing, give up reading generation");
+			return 0;
 		}
 
-		inline std::list<std::string /*section name*/> sectionsList()
+	private:
+		const ShmHeader *header() const
 		{
-			return _iniData.getSectionsList();
+			return reinterpret_cast<const ShmHeader *>(_base);
 		}
 
-		inline std::map<std::string /*key*/, std::string /*value*/> sectionMap(const std::string &sectionName)
+		// offsets may be torn while publishing: check every range
+		bool isInside(std::uint64_t offset, std::uint64_t size) const
 		{
-			return _iniData.getSectionMap(sectionName);
+			return offset <= _capacity && size <= _capacity - offset;
 		}
 
-		void setFileName(const std::string &fileName)
+		static int compare(const char *data, std::size_t length, const std::string &name)
 		{
-			_configFileName = fileName;
+			int result = std::memcmp(data, name.data(), std::min(length, name.length()));
+			if (result != 0)
+			{
+				return result;
+			}
+			return length < name.length() ? -1 : (length > name.length() ? 1 : 0);
 		}
 
-	private:
-		bool filterData(std::string &data)
+		// binary search in a sorted table of Entry, with name/nameLength or key/keyLength
+		template <typename Entry, typename Name>
+		const Entry *search(std::uint64_t table, std::uint32_t count, const std::string &name, Name nameOf) const
 		{
-			if (data.length() == 0)
+			if (!isInside(table, static_cast<std::uint64_t>(count) * sizeof(Entry)))
 			{
-				return false;
+				return nullptr;
+			}
+
+			const Entry *entries = reinterpret_cast<const Entry *>(_base + table);
+			std::uint32_t low = 0, high = count;
+			while (low < high)
+			{
+				std::uint32_t middle = low + (high - low) / 2;
+				std::uint64_t offset = 0, length = 0;
+				nameOf(entries[middle], offset, length);
+				if (!isInside(offset, length))
+				{
+					return nullptr;
+				}
+
+				int result = compare(_base + offset, static_cast<std::size_t>(length), name);
+				if (result == 0)
+				{
+					return &entries[middle];
+				}
+				if (result < 0)
+				{
+					low = middle + 1;
+				}
+				else
+				{
+					high = middle;
+				}
 			}
+			return nullptr;
+		}
 
-			if (data[0] == ';')
+		bool find(const std::string &Section, const std::string &Key, std::string &value) const
+		{
+			const ShmSection *sec = search<ShmSection>(align(sizeof(ShmHeader)), header()->sectionCount, Section, [](const ShmSection &entry, std::uint64_t &offset, std::uint64_t &length)
+													   { offset = entry.name; length = entry.nameLength; });
+			if (!sec)
 			{
 				return false;
 			}
 
-			if (data[0] == '#')
+			const ShmKey *key = search<ShmKey>(sec->keyTable, sec->keyCount, Key, [](const ShmKey &entry, std::uint64_t &offset, std::uint64_t &length)
+											   { offset = entry.key; length = entry.keyLength; });
+			if (!key || !isInside(key->value, key->valueLength))
 			{
 				return false;
 			}
 
+			value.assign(_base + key->value, key->valueLength);
 			return true;
 		}
 
-		void trimEdges(std::string &data)
-		{
-			// remove left ' ' and '\t'
-			data.erase(data.begin(), std::find_if(data.begin(), data.end(), [](unsigned char c)
-												  { return !std::isspace(c); }));
-			// remove right ' ' and '\t'
-			data.erase(std::find_if(data.rbegin(), data.rend(), [](unsigned char c)
-									{ return !std::isspace(c); })
-						   .base(),
-					   data.end());
-
-			// INI_DEBUG("trimEdges data:|" << data << "|");
-		}
-
 	private:
-		ini _iniData;
-		int _SumOfLines;
-		std::fstream _iniFile;
-		std::string _configFileName;
+		const char *_base = nullptr;
+		std::size_t _capacity = 0;
 	};
+#endif
 
 } // namespace inicpp
 